@@ -8,42 +8,76 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <hal.h>
 #include <sensors/imu.h>
 #include <sensors/mpu9250.h>
 #include <i2c_bus.h>
 #include <msgbus/messagebus.h>
 #include <angle.h>
-#include <average.h>
+#include <executive.h>
+#include <calibration.h>
+#include <timebase.h>
+#include <chprintf.h>
 
-#define PI 3.14
+// time to execute thread content : measured by the benchmark (see bench.c)
+#define COMPUTE_ANGLE_PERIOD 5 // period (in ms) of the thread that computes the angle, rounded to whole IMU samples with IMU_TOPIC (ANGLE_PERIOD_FAST)
+#define COMPUTE_ANGLE_PERIOD_SLOW 20 // period (in ms) when the surface is flat or the heading is stable, multiple of COMPUTE_ANGLE_PERIOD
 
-// measured time to execute thread content : 2 us
-#define COMPUTE_ANGLE_PERIOD 5 // period (in ms) of the thread that computes the angle
+#define ADAPTIVE_PERIOD true // true to slow down the angle computation when it isn't needed
+
+#define IMU_TOPIC true // true to process each sample published by the IMU once, false to read the IMU at the period of the angle computation
+
+#define INCL_MARGIN 100 // under INCL_LIMIT - INCL_MARGIN, the surface is flat enough to compute the angle slowly
+#define HEADING_VAR_LIMIT 4 // above this variance of the angle [deg^2], the heading isn't stable
 
 // accelerometer axis
 #define X_AXIS 0
 #define Y_AXIS 1
 #define Z_AXIS 2
+#define NB_AXIS 3
+
+#define IMU_PERIOD 4 // period of the samples of the IMU [ms] (250 Hz, e-puck2 library)
 
-#define INCL_LIMIT 300 // inclination threshold, if the slope isn't sufficient, the angle is 0
+// real fast period [ms] : with IMU_TOPIC the thread computes on one sample every period / IMU_PERIOD (5 ms gives 4 ms)
+// the cyclic executive reads the IMU at COMPUTE_ANGLE_PERIOD (angle_task)
+#define ANGLE_PERIOD_FAST ANGLE_PERIOD_REAL(COMPUTE_ANGLE_PERIOD, IMU_PERIOD, IMU_TOPIC && !CYCLIC_EXECUTIVE)
 
-#define AVERAGE_ANGLE_SIZE 10 // number of values to use to compute the angle average
-#define AVERAGE_SLOPE_SIZE 10 // number of values to use to compute the slope average
+// number of values of the averages (AVERAGE_*_TIME in estimate.h), from the real period : 10 when reading the IMU,
+// 13 with IMU_TOPIC (52 ms)
+#define AVERAGE_ANGLE_SIZE AVERAGE_SIZE(AVERAGE_ANGLE_TIME, ANGLE_PERIOD_FAST)
+#define AVERAGE_SLOPE_SIZE AVERAGE_SIZE(AVERAGE_SLOPE_TIME, ANGLE_PERIOD_FAST)
+AVERAGE_SIZE_CHECK(AVERAGE_ANGLE_SIZE);
+AVERAGE_SIZE_CHECK(AVERAGE_SLOPE_SIZE);
 
 extern messagebus_t bus; // communication variable defined in main.c
 
-static int16_t angle_mean = 0;
+static estimate_t estimate = ESTIMATE_INIT(AVERAGE_ANGLE_SIZE, AVERAGE_SLOPE_SIZE); // averages of the slope (estimate.c)
+static heading_t angle_mean = 0;
 static bool flat = true; // true if the slope is small (useful for the regulator)
+static int16_t incl_mean = 0; // averaged acceleration on the Z axis
+static int32_t angle_var = 0; // variance of the last angle values [heading^2]
+static angle_stats_t stats = {0}; // load of the angle thread
+static imu_stats_t imu_stats = {0}; // delivery of the IMU samples
+static BSEMAPHORE_DECL(ready, true); // taken until the averages are filled (angle_wait_ready())
 
 /*
  * allows to get the last computed angle value from another file
  *
- * \return	computed angle
+ * \return	computed angle [heading]
  */
-int16_t get_angle(void) {
+heading_t get_angle(void) {
 	return angle_mean;
 }
 
+/*
+ * allows to get the inclination of the surface from another file
+ *
+ * \return	averaged acceleration on the Z axis (offset removed), bigger on a steeper slope
+ */
+int16_t get_inclination(void) {
+	return incl_mean;
+}
+
 /*
  * returns the state of the surface in another file
  *
@@ -54,82 +88,241 @@ bool get_slope(void) {
 }
 
 /*
- * computes and returns the slope angle according to the defined convention (left : [-180, 0[ ; right : ]0, +180])
+ * computes and returns the averaged slope angle
+ * In a flat surface, it is undefined, in that there is an inclination threshold and it is put to 0
  *
- *         BACK
- *         ####
- *      #180/-180#
- *    #            #
- * R # 90  TOP  -90 # L
- *    #    VIEW    #
- *      #   0    #
- *         ####
- *         FRONT
+ * \param acc	raw accelerations of one sample of the IMU (X, Y, Z)
  *
- * The slope angle is the direction of descending slope in an inclined plane
- * In a flat surface, it is undefined, in that there is an inclination threshold and it is put to 0
+ * \return	computed angle [heading]
+ */
+heading_t compute_angle(const int16_t* acc){
+
+	int16_t calibrated[NB_AXIS] = {0};	// accelerations, offsets removed
+	heading_t angle = 0;				// computed angle (value to regulate)
+	int64_t var = 0;
+
+	for(uint8_t i = 0 ; i < NB_AXIS ; i++) {
+		calibrated[i] = acc[i] - get_acc_calibration(i); // the three axes come from the same sample
+	}
+
+	angle = estimate_update(&estimate, calibrated); // averages of the inclination and of the angle (estimate.c)
+
+	// variance of the last angles, to know if the heading is stable
+	// on 64 bits : a square of a difference of headings nearly fills 32 bits
+	for(uint8_t i = 0 ; i < AVERAGE_ANGLE_SIZE ; i++) {
+		var += (int32_t)(estimate.values_angle[i] - angle) * (estimate.values_angle[i] - angle);
+	}
+	angle_var = var / AVERAGE_ANGLE_SIZE;
+	flat = estimate.flat;
+	incl_mean = estimate.inclination;
+
+	return angle;
+}
+
+/*
+ * chooses the period of the next angle computation
+ * fast when the slope is close to the inclination threshold or when the heading moves
+ * slow when the surface is clearly flat or when the heading is stable
  *
- * \return	computed angle
+ * \return	period [ms]
  */
-int16_t compute_angle(void){
+static uint16_t angle_period(void) {
+	if(!ADAPTIVE_PERIOD) {
+		return COMPUTE_ANGLE_PERIOD;
+	}
 
-	int16_t acc_x = 0;					// acceleration on the X axis
-	int16_t acc_y = 0;					// acceleration on the Y axis
-	int16_t acc_z = 0;					// acceleration on the Z axis
-	int16_t acc_z_mean = 0;				// mean of acceleration Z
-	int16_t angle = 0;					// computed angle (value to regulate)
+	// flat surface, far enough from the threshold
+	if(flat && incl_mean < INCL_LIMIT - INCL_MARGIN) {
+		return COMPUTE_ANGLE_PERIOD_SLOW;
+	}
 
-	// values to keep for the average computing
-	static int32_t sum_angle = 0;
-	static int16_t values_angle[AVERAGE_ANGLE_SIZE] = {0};
-	static int16_t counter_angle = 0;
-	static int32_t sum_slope = 0;
-	static int16_t values_slope[AVERAGE_SLOPE_SIZE] = {0};
-	static int16_t counter_slope = 0;
+	// slope with a stable heading
+	if(!flat && angle_var < HEADING_VAR_LIMIT * HEADING_SCALE * HEADING_SCALE) {
+		return COMPUTE_ANGLE_PERIOD_SLOW;
+	}
 
-	acc_z = get_acc(Z_AXIS) - get_acc_offset(Z_AXIS); // acquires the acceleration on the Z axis and removes the offset from the calibration.
+	return COMPUTE_ANGLE_PERIOD;
+}
 
-	acc_z_mean = average(acc_z, &sum_slope, values_slope, &counter_slope, AVERAGE_SLOPE_SIZE); // averaging of the value
+/*
+ * gives the load of the angle thread since its start
+ * wakeups_saved and the time saved are compared to a thread always running at ANGLE_PERIOD_FAST
+ *
+ * \param load		structure to fill
+ */
+void get_angle_stats(angle_stats_t* load) {
+	chSysLock();
+	*load = stats;
+	chSysUnlock();
+}
 
-	if(acc_z_mean > INCL_LIMIT) {
-		flat =  false; // slope is sufficient to start regulation
-		acc_x = get_acc(X_AXIS) - get_acc_offset(X_AXIS); // acquires the acceleration on the X axis and removes the offset from the calibration.
+/*
+ * counts the delivery of a sample of the IMU to the angle computation
+ * the samples produced are counted with the time elapsed since the first delivery
+ * a sample equal to the previous one is a duplicate : the noise of the IMU changes the values at each sample
+ *
+ * \param acc			raw accelerations delivered
+ *
+ * \param torn			true if the accelerations come from two samples
+ */
+static void imu_delivered(const int16_t* acc, bool torn) {
+	static uint64_t first = 0; // time of the first delivery [us]
+	static int16_t acc_last[NB_AXIS] = {0};
+	uint64_t now = timebase_us();
+	bool same = acc[X_AXIS] == acc_last[X_AXIS] && acc[Y_AXIS] == acc_last[Y_AXIS] && acc[Z_AXIS] == acc_last[Z_AXIS];
 
-		acc_y = get_acc(Y_AXIS) - get_acc_offset(Y_AXIS); // acquires the acceleration on the Y axis and removes the offset from the calibration.
+	if(first == 0) {
+		first = now;
+	}
 
-		angle=(180/PI)*atan(((float)acc_y)/((float)acc_x));	// computes the angle and converts it in degrees
+	chSysLock();
+	imu_stats.samples = (now - first) / (IMU_PERIOD * 1000);
+	imu_stats.processed++;
+	imu_stats.duplicates += same;
+	imu_stats.torn += torn;
+	chSysUnlock();
 
-		// corrects the angle value according to the orientation of the accelerometer (see axis printed on the body)
+	for(uint8_t i = 0 ; i < NB_AXIS ; i++) {
+		acc_last[i] = acc[i];
+	}
+}
 
-		// dial 1
-		if(acc_x > 0 && acc_y > 0){
-			angle = -angle - 90;
-		}
+/*
+ * counts the samples of the IMU skipped on purpose (slow period with IMU_TOPIC), without waking up for them
+ *
+ * \param skip		number of samples skipped
+ */
+static void imu_skipped(uint16_t skip) {
+	chSysLock();
+	imu_stats.decimated += skip;
+	chSysUnlock();
+}
 
-		// dial 2
-		if(acc_x < 0 && acc_y > 0){
-			angle = -angle + 90;
-		}
+/*
+ * angle computation on a sample, measures its own load
+ *
+ * \param acc		raw accelerations of the sample
+ *
+ * \param period	expected time since the last computation [ms]
+ *
+ * \return			period until the next computation [ms]
+ */
+static uint16_t angle_process(const int16_t* acc, uint16_t period) {
+	static uint16_t computations = 0; // since the start, until the averages are filled
+	uint64_t start = 0; // beginning of the computation [us]
 
-		// dial 3
-		if(acc_x < 0 && acc_y < 0){
-			angle = -angle + 90;
-		}
+	release_update(TASK_ANGLE, period);
+	start = timebase_us();
+
+	angle_mean = compute_angle(acc); // angle computation function
+	period = angle_period();
 
-		// dial 4
-		if(acc_x > 0 && acc_y <0){
-			angle = -angle - 90;
+	// load measurement
+	chSysLock();
+	stats.wakeups++;
+	stats.wakeups_saved += period / ANGLE_PERIOD_FAST - 1;
+	stats.busy_us += timebase_us() - start;
+	chSysUnlock();
+
+	// the averages hold only measurements : the angle can be used
+	if(computations < AVERAGE_ANGLE_SIZE || computations < AVERAGE_SLOPE_SIZE) {
+		computations++;
+		if(computations >= AVERAGE_ANGLE_SIZE && computations >= AVERAGE_SLOPE_SIZE) {
+			chBSemSignal(&ready);
 		}
-	} else {
-		angle = 0;
-		flat = true; // slope isn't sufficient to start regulation
 	}
 
-	return(average(angle, &sum_angle, values_angle, &counter_angle, AVERAGE_ANGLE_SIZE)); // averageing of the angle
+	return period;
+}
+
+/*
+ * waits until the averages of the angle are filled by the computations (thread or cyclic executive)
+ * to call once, after compute_angle_thd_start()
+ */
+void angle_wait_ready(void) {
+	chBSemWait(&ready);
+}
+
+/*
+ * angle computation reading the IMU, called every period returned
+ * the three axes are read one after the other : a sample of the IMU can arrive between the reads,
+ * detected when the Z axis read again has changed
+ *
+ * \return	period until the next computation [ms]
+ */
+uint16_t angle_task(void) {
+	static uint16_t period = COMPUTE_ANGLE_PERIOD; // period since the last computation [ms]
+	int16_t acc[NB_AXIS] = {0};
+	bool torn = false;
+
+	acc[Z_AXIS] = get_acc(Z_AXIS);
+	acc[X_AXIS] = get_acc(X_AXIS);
+	acc[Y_AXIS] = get_acc(Y_AXIS);
+	torn = get_acc(Z_AXIS) != acc[Z_AXIS];
+
+	imu_delivered(acc, torn);
+	period = angle_process(acc, period);
+
+	return period;
+}
+
+/*
+ * gives the delivery of the IMU samples to the angle computation since its start
+ * samples - (processed - duplicates) - decimated is the number of samples dropped
+ *
+ * \param delivery		structure to fill
+ */
+void get_imu_stats(imu_stats_t* delivery) {
+	chSysLock();
+	*delivery = imu_stats;
+	chSysUnlock();
+}
+
+/*
+ * sends the load of the angle computation (ADAPTIVE_PERIOD) and the delivery of the IMU samples,
+ * to compare IMU_TOPIC true and false
+ * the slow periods of the polling (ADAPTIVE_PERIOD) are counted as drops : compare without it
+ *
+ * \param out		stream to write to
+ */
+void angle_print(BaseSequentialStream* out) {
+	angle_stats_t load;
+	imu_stats_t d;
+	uint32_t drops = 0;
+
+	get_angle_stats(&load);
+	if(load.wakeups != 0) {
+		chprintf(out, "\r\nangle computations : %u, period %u ms or %u ms\r\n", load.wakeups, ANGLE_PERIOD_FAST,
+				ADAPTIVE_PERIOD ? COMPUTE_ANGLE_PERIOD_SLOW : ANGLE_PERIOD_FAST);
+		chprintf(out, "busy                 %u us (%u us per computation)\r\n", load.busy_us, load.busy_us / load.wakeups);
+		chprintf(out, "wake-ups saved       %u (%.1f %%), about %u us\r\n", load.wakeups_saved,
+				100.f * load.wakeups_saved / (load.wakeups + load.wakeups_saved),
+				(uint32_t)((uint64_t)load.busy_us * load.wakeups_saved / load.wakeups));
+	}
+
+	get_imu_stats(&d);
+	if(d.samples == 0) {
+		return;
+	}
+	drops = d.samples - (d.processed - d.duplicates) - d.decimated;
+	if(drops > d.samples) { // more samples seen than counted with the time (rounding)
+		drops = 0;
+	}
+
+	chprintf(out, "\r\nIMU samples (%s) : %u\r\n", IMU_TOPIC ? "topic" : "polling", d.samples);
+	chprintf(out, "processed            %u\r\n", d.processed);
+	chprintf(out, "duplicates           %u (%.2f %%)\r\n", d.duplicates, 100.f * d.duplicates / d.samples);
+	chprintf(out, "dropped              %u (%.2f %%)\r\n", drops, 100.f * drops / d.samples);
+	chprintf(out, "torn                 %u (%.2f %%)\r\n", d.torn, 100.f * d.torn / d.samples);
+	chprintf(out, "decimated            %u\r\n", d.decimated);
 }
 
 /*
  * thread dedicated to the timing of the slope angle computation
+ * IMU_TOPIC : woken by each sample published on the bus, the three axes are copied at once by the bus
+ * the slow period is made of samples skipped on purpose : the thread sleeps through them and reads the last sample
+ * half a sample after its publication (a release jitter under IMU_PERIOD / 2 gives neither duplicate nor drop)
+ * otherwise : wakes up every period and reads the IMU
  */
 static THD_WORKING_AREA(compute_angle_thd_wa, 1024);
 static THD_FUNCTION(compute_angle_thd, arg){
@@ -138,22 +331,57 @@ static THD_FUNCTION(compute_angle_thd, arg){
 	(void) arg;
 
 	systime_t time;
+	uint16_t period = ANGLE_PERIOD_FAST; // period until the next computation [ms]
+	messagebus_topic_t* imu_topic = NULL;
+	imu_msg_t imu_values;
+	uint16_t skip = 0; // samples to skip before the next computation
+
+	if(IMU_TOPIC) {
+		imu_topic = messagebus_find_topic_blocking(&bus, "/imu");
+		messagebus_topic_wait(imu_topic, &imu_values, sizeof(imu_values));
+		time = chVTGetSystemTime(); // publication of the sample
+		while(1) {
+			imu_delivered(imu_values.acc_raw, false);
+			period = angle_process(imu_values.acc_raw, period);
+			skip = (period > IMU_PERIOD) ? period / IMU_PERIOD - 1 : 0;
+			period = (skip + 1) * IMU_PERIOD; // expected time until the next computation
+
+			if(skip == 0) {
+				messagebus_topic_wait(imu_topic, &imu_values, sizeof(imu_values));
+				time = chVTGetSystemTime();
+				continue;
+			}
+
+			// slow period : sleeps through the skipped samples, wakes up half a sample after the one to process
+			imu_skipped(skip);
+			chThdSleepUntilWindowed(time, time + MS2ST(period) + MS2ST(IMU_PERIOD) / 2);
+			messagebus_topic_read(imu_topic, &imu_values, sizeof(imu_values));
+			time += MS2ST(period);
+		}
+	}
 
 	while(1){
 		time = chVTGetSystemTime();
 
-    	angle_mean = compute_angle(); // angle computation function
+		period = angle_task();
 
-		chThdSleepUntilWindowed(time, time + MS2ST(COMPUTE_ANGLE_PERIOD));
+		chThdSleepUntilWindowed(time, time + MS2ST(period));
 	}
 }
 
 /*
- * inits and calibrates the IMU, starts the thread that computes the angle
+ * calibrates the IMU if needed, starts the thread that computes the angle
+ * the IMU must be started
+ *
+ * \param calibrate		true to calibrate, false to use the stored calibration
  */
-void compute_angle_thd_start(){
-	imu_start(); // starts the IMU
-    calibrate_acc(); // calibrates the IMU
-    chThdSleepMilliseconds(1500); //time after calibration and before the first measurement
-	chThdCreateStatic(compute_angle_thd_wa, sizeof(compute_angle_thd_wa), NORMALPRIO, compute_angle_thd, NULL); // starts the thread dedicated to the computation of the angle
+void compute_angle_thd_start(bool calibrate){
+	if(calibrate) {
+		calibrate_acc(); // calibrates the IMU
+		calibration_store_acc(); // keeps the offsets for the next boots
+		chThdSleepMilliseconds(1500); //time after calibration and before the first measurement
+	}
+	if(!CYCLIC_EXECUTIVE) { // with the cyclic executive, the angle computation is one of its tasks
+		chThdCreateStatic(compute_angle_thd_wa, sizeof(compute_angle_thd_wa), NORMALPRIO, compute_angle_thd, NULL); // starts the thread dedicated to the computation of the angle
+	}
 }
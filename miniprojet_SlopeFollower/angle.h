@@ -8,9 +8,34 @@
 #ifndef ANGLE_H_
 #define ANGLE_H_
 
-int16_t get_angle(void);
+#include <hal.h>
+#include <estimate.h>
+
+// load of the thread that computes the angle
+typedef struct {
+	uint32_t wakeups;			// number of computations since the start
+	uint32_t wakeups_saved;		// computations avoided compared to the fixed period
+	uint32_t busy_us;			// time spent in the computations [us], busy_us / wakeups * wakeups_saved is the time saved
+} angle_stats_t;
+
+// delivery of the IMU samples to the angle computation, since the start
+typedef struct {
+	uint32_t samples;		// samples produced by the IMU, counted with the time elapsed
+	uint32_t processed;		// samples given to the computation
+	uint32_t duplicates;	// samples processed again (same values as the previous one)
+	uint32_t torn;			// accelerations mixing two samples
+	uint32_t decimated;		// samples skipped on purpose (slow period with IMU_TOPIC)
+} imu_stats_t;
+
+heading_t get_angle(void);
 bool get_slope(void);
-int16_t compute_angle(void);
-void compute_angle_thd_start(void);
+int16_t get_inclination(void);
+heading_t compute_angle(const int16_t* acc);
+void get_angle_stats(angle_stats_t* load);
+void get_imu_stats(imu_stats_t* delivery);
+void angle_print(BaseSequentialStream* out);
+uint16_t angle_task(void);
+void compute_angle_thd_start(bool calibrate);
+void angle_wait_ready(void);
 
 #endif /* ANGLE_H_ */
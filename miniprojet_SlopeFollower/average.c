@@ -35,3 +35,29 @@ int16_t average(int16_t new_value, int32_t* sum, int16_t* values, int16_t* count
 
 	return *sum / size; // compute and return the average
 }
+
+/*
+ * Restarts a moving average from one value : the history is forgotten
+ *
+ * \param value			Value to fill the table with
+ *
+ * \param sum			Moving sum to be modified
+ *
+ * \param values		Table of last values to be modified
+ *
+ * \param counter		Knows the position of the last value, to be modified
+ *
+ * \param size			Number of values to average
+ *
+ * \return				Average value (value)
+ */
+int16_t average_fill(int16_t value, int32_t* sum, int16_t* values, int16_t* counter, int16_t size) {
+
+	for(int16_t i = 0 ; i < size ; i++) {
+		values[i] = value;
+	}
+	*sum = (int32_t)value * size;
+	*counter = 0;
+
+	return value;
+}
@@ -9,5 +9,6 @@
 #define AVERAGE_H_
 
 int16_t average(int16_t new_value, int32_t* sum, int16_t* values, int16_t* counter, int16_t size);
+int16_t average_fill(int16_t value, int32_t* sum, int16_t* values, int16_t* counter, int16_t size);
 
 #endif /* AVERAGE_H_ */
@@ -0,0 +1,288 @@
+/*
+ * bench.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <ch.h>
+#include <hal.h>
+#include <chprintf.h>
+#include <leds.h>
+#include <angle.h>
+#include <average.h>
+#include <prox.h>
+#include <regulation.h>
+#include <bench.h>
+#include <bench_baseline.h>
+#include <timebase.h>
+
+// customizable parameters
+
+#define BENCH_REGRESSION_PERCENT 20 // a case fails if its mean is more than this percentage above its baseline
+
+#define BENCH_WARMUP 5 // repetitions done before the measured ones (flash cache, branch history)
+#define BENCH_REPETITIONS 20 // measured repetitions of each case
+#define BENCH_ITERATIONS 100 // calls of the function per repetition (timer 12 only counts us)
+
+// end of customizable parameters
+
+#define AVERAGE_MAX_SIZE 32 // biggest window tested for the moving average
+
+#define SERIAL_OUT ((BaseSequentialStream *)&SD3)
+
+// stored result of a case, 0 without stored baseline
+#if BENCH_BASELINE
+#define BASELINE(name) BASELINE_##name
+#else
+#define BASELINE(name) 0
+#endif
+
+// one measured case : the function to call and its inputs
+typedef struct {
+	const char* name;					// name of the case (suffix of the baseline define)
+	void (*op)(const int16_t* in);		// calls once the function to measure
+	int16_t in[6];						// inputs given to op
+	uint32_t baseline;					// stored result [ns/op], 0 without stored baseline
+} bench_case_t;
+
+static volatile int32_t sink = 0; // results are written here so that the calls are not optimized out
+
+// values used by the moving average cases
+static int32_t sum_average = 0;
+static int16_t values_average[AVERAGE_MAX_SIZE] = {0};
+static int16_t counter_average = 0;
+
+/*
+ * functions called by the cases
+ * in[] gives the inputs, see the table of the cases
+ */
+static void op_empty(const int16_t* in) {
+	sink = in[0];
+}
+
+static void op_slope_angle(const int16_t* in) {
+	sink = slope_angle(in[0], in[1]);
+}
+
+// in[] are the raw accelerations : 0, the flat branch is taken
+static void op_compute_angle(const int16_t* in) {
+	sink = compute_angle(in);
+}
+
+static void op_regulator(const int16_t* in) {
+	sink = regulator(in[0], 0, in[1]);
+}
+
+static void op_average(const int16_t* in) {
+	sink = average(in[1], &sum_average, values_average, &counter_average, in[0]);
+}
+
+static void op_prox_alert(const int16_t* in) {
+	sink = compute_prox_alert(in[0], in[1], in[2], in[3], in[4], in[5]);
+}
+
+static void op_prox_obstacle(const int16_t* in) {
+	prox_obstacle_t obstacle;
+
+	compute_prox_obstacle(in, &obstacle);
+	sink = obstacle.bearing;
+}
+
+static void op_escape(const int16_t* in) {
+	prox_obstacle_t obstacle = {in[1], in[2]};
+
+	sink = escape(in[0], &obstacle);
+}
+
+/*
+ * measured cases
+ * regulator : in[0] is the angle [heading], in[1] the mode, in[2] the periods run at this angle before the measure
+ *   linear : small error, no saturation
+ *   reset : biggest error but reset at each call, the integral term never accumulates
+ *   ARW : biggest error without reset, the integral term grows until the saturation
+ *   saturated : biggest error with the integral term pre-loaded, the output is over the limit and the integral term
+ *     is pulled back at each call
+ * average : in[0] is the window size, in[1] the new value
+ * proximity : in[] are the values of right_3, right_2, right_1, left_1, left_2, left_3
+ * escape : in[0] is the alert, in[1] the bearing [heading] and in[2] the range [mm] of the obstacle
+ */
+static bench_case_t cases[] = {
+	{"ANGLE_DIAL_1",		op_slope_angle,		{200, 100},						BASELINE(ANGLE_DIAL_1)},
+	{"ANGLE_DIAL_2",		op_slope_angle,		{-200, 100},					BASELINE(ANGLE_DIAL_2)},
+	{"ANGLE_DIAL_3",		op_slope_angle,		{-200, -100},					BASELINE(ANGLE_DIAL_3)},
+	{"ANGLE_DIAL_4",		op_slope_angle,		{200, -100},					BASELINE(ANGLE_DIAL_4)},
+	{"ANGLE_X_ZERO",		op_slope_angle,		{0, 100},						BASELINE(ANGLE_X_ZERO)},
+	{"ANGLE_FLAT",			op_compute_angle,	{0},							BASELINE(ANGLE_FLAT)},
+
+	{"REGUL_LINEAR",		op_regulator,		{1000, REGUL_RUN},				BASELINE(REGUL_LINEAR)},
+	{"REGUL_RESET",			op_regulator,		{18000, REGUL_RESET},			BASELINE(REGUL_RESET)},
+	{"REGUL_ARW",			op_regulator,		{18000, REGUL_RUN},				BASELINE(REGUL_ARW)},
+	{"REGUL_SATURATED",		op_regulator,		{18000, REGUL_RUN, 200},		BASELINE(REGUL_SATURATED)},
+
+	{"AVERAGE_4",			op_average,			{4, 123},						BASELINE(AVERAGE_4)},
+	{"AVERAGE_10",			op_average,			{10, 123},						BASELINE(AVERAGE_10)},
+	{"AVERAGE_32",			op_average,			{32, 123},						BASELINE(AVERAGE_32)},
+
+	{"PROX_NONE",			op_prox_alert,		{100, 100, 100, 100, 100, 100},	BASELINE(PROX_NONE)},
+	{"PROX_R_SIDE",			op_prox_alert,		{900, 100, 100, 100, 100, 100},	BASELINE(PROX_R_SIDE)},
+	{"PROX_R_CENTER",		op_prox_alert,		{100, 900, 100, 100, 100, 100},	BASELINE(PROX_R_CENTER)},
+	{"PROX_R_FRONT",		op_prox_alert,		{100, 100, 900, 100, 100, 100},	BASELINE(PROX_R_FRONT)},
+	{"PROX_L_FRONT",		op_prox_alert,		{100, 100, 100, 900, 100, 100},	BASELINE(PROX_L_FRONT)},
+	{"PROX_L_CENTER",		op_prox_alert,		{100, 100, 100, 100, 900, 100},	BASELINE(PROX_L_CENTER)},
+	{"PROX_L_SIDE",			op_prox_alert,		{100, 100, 100, 100, 100, 900},	BASELINE(PROX_L_SIDE)},
+	{"PROX_OBSTACLE",		op_prox_obstacle,	{100, 100, 900, 700, 100, 100},	BASELINE(PROX_OBSTACLE)},
+
+	{"ESCAPE_R_SIDE",		op_escape,			{R_SIDE, -9000, 60},			BASELINE(ESCAPE_R_SIDE)},
+	{"ESCAPE_R_CENTER",		op_escape,			{R_CENTER, -4900, 60},			BASELINE(ESCAPE_R_CENTER)},
+	{"ESCAPE_R_FRONT",		op_escape,			{R_FRONT, -1700, 60},			BASELINE(ESCAPE_R_FRONT)},
+	{"ESCAPE_L_FRONT",		op_escape,			{L_FRONT, 1700, 60},			BASELINE(ESCAPE_L_FRONT)},
+	{"ESCAPE_L_CENTER",		op_escape,			{L_CENTER, 4900, 60},			BASELINE(ESCAPE_L_CENTER)},
+	{"ESCAPE_L_SIDE",		op_escape,			{L_SIDE, 9000, 60},				BASELINE(ESCAPE_L_SIDE)},
+};
+
+#define NB_CASES (sizeof(cases) / sizeof(cases[0]))
+
+static uint32_t results[NB_CASES] = {0}; // mean of each case [ns/op]
+
+/*
+ * measures one repetition of a case with the microsecond time base
+ *
+ * \param bc		case to measure
+ *
+ * \return			mean time of one call during this repetition [ns]
+ */
+static uint32_t bench_repetition(const bench_case_t* bc) {
+	uint64_t start = 0;
+	uint64_t stop = 0;
+
+	start = timebase_us();
+	for(uint16_t i = 0 ; i < BENCH_ITERATIONS ; i++) {
+		bc->op(bc->in);
+	}
+	stop = timebase_us();
+
+	return (uint32_t)(stop - start) * 1000 / BENCH_ITERATIONS;
+}
+
+/*
+ * measures a case : warm-up, then repetitions
+ * the regulator and the moving average are reset before each case so that the regimes don't depend on the previous case
+ *
+ * \param bc		case to measure
+ *
+ * \param overhead	time of the call of an empty case, removed from the result [ns]
+ *
+ * \param mean		mean of the repetitions [ns/op]
+ *
+ * \param sd		standard deviation of the repetitions [ns/op]
+ *
+ * \param min		fastest repetition [ns/op]
+ */
+static void bench_case(const bench_case_t* bc, uint32_t overhead, uint32_t* mean, uint32_t* sd, uint32_t* min) {
+	uint32_t times[BENCH_REPETITIONS] = {0};
+	float sum = 0;
+	float var = 0;
+
+	regulator(0, 0, REGUL_RESET);
+	if(bc->op == op_regulator) {
+		for(int16_t i = 0 ; i < bc->in[2] ; i++) {
+			regulator(bc->in[0], 0, REGUL_RUN); // pre-loads the integral term
+		}
+	}
+	sum_average = 0;
+	counter_average = 0;
+	for(uint8_t i = 0 ; i < AVERAGE_MAX_SIZE ; i++) {
+		values_average[i] = 0;
+	}
+
+	for(uint8_t i = 0 ; i < BENCH_WARMUP ; i++) {
+		bench_repetition(bc);
+	}
+
+	*min = UINT32_MAX;
+	for(uint8_t i = 0 ; i < BENCH_REPETITIONS ; i++) {
+		times[i] = bench_repetition(bc);
+		times[i] = (times[i] > overhead) ? times[i] - overhead : 0;
+		sum += times[i];
+		if(times[i] < *min) {
+			*min = times[i];
+		}
+	}
+	*mean = sum / BENCH_REPETITIONS;
+
+	for(uint8_t i = 0 ; i < BENCH_REPETITIONS ; i++) {
+		var += ((float)times[i] - *mean) * ((float)times[i] - *mean);
+	}
+	*sd = sqrtf(var / BENCH_REPETITIONS);
+}
+
+/*
+ * runs all the cases, sends the results on the serial port (UART3) and compares them with the baseline (bench_baseline.h)
+ * the escape cases only give a command to the drive (nothing calls drive_update()) : the wheels don't turn
+ * without stored baseline (BENCH_BASELINE false), the results are only sent, to be copied in bench_baseline.h
+ * with a stored baseline, a case at 0 can't be checked : the benchmark fails until the new baseline is stored
+ *
+ * \return		true if nothing is compared, or if every case has a baseline and no case is slower than it
+ * 				by more than BENCH_REGRESSION_PERCENT
+ */
+bool benchmark_run(void) {
+	static const bench_case_t empty = {"EMPTY", op_empty, {0}, 0};
+	uint32_t overhead = 0;
+	uint32_t mean = 0;
+	uint32_t sd = 0;
+	uint32_t min = 0;
+	uint8_t regressions = 0;
+	uint8_t missing = 0; // cases without baseline
+
+	// time of the loop and of the call, without the function to measure
+	bench_case(&empty, 0, &overhead, &sd, &min);
+
+	chprintf(SERIAL_OUT, "\r\nbenchmark : %d warm-up, %d x %d calls, overhead %u ns removed, limit +%d %%\r\n",
+			BENCH_WARMUP, BENCH_REPETITIONS, BENCH_ITERATIONS, overhead, BENCH_REGRESSION_PERCENT);
+	chprintf(SERIAL_OUT, "%-16s %8s %8s %8s %8s\r\n", "case", "ns/op", "sd", "min", "baseline");
+
+	for(uint8_t i = 0 ; i < NB_CASES ; i++) {
+		bench_case(&cases[i], overhead, &mean, &sd, &min);
+		results[i] = mean;
+
+		chprintf(SERIAL_OUT, "%-16s %8u %8u %8u %8u", cases[i].name, mean, sd, min, cases[i].baseline);
+		if(!BENCH_BASELINE) {
+			chprintf(SERIAL_OUT, "\r\n");
+		} else if(cases[i].baseline == 0) {
+			chprintf(SERIAL_OUT, "  NO BASELINE\r\n");
+			missing++;
+		} else if(mean * 100 > cases[i].baseline * (100 + BENCH_REGRESSION_PERCENT)) {
+			chprintf(SERIAL_OUT, "  REGRESSION\r\n");
+			regressions++;
+		} else {
+			chprintf(SERIAL_OUT, "  ok\r\n");
+		}
+	}
+
+	// LEDs used by the escape cases
+	clear_leds();
+
+	// new baseline, to copy in bench_baseline.h
+	chprintf(SERIAL_OUT, "\r\n");
+	for(uint8_t i = 0 ; i < NB_CASES ; i++) {
+		chprintf(SERIAL_OUT, "#define BASELINE_%-16s %u\r\n", cases[i].name, results[i]);
+	}
+
+	if(!BENCH_BASELINE) {
+		chprintf(SERIAL_OUT, "\r\nbenchmark measured, no baseline stored : copy the lines above in bench_baseline.h\r\n");
+		return true;
+	}
+	if(regressions != 0 || missing != 0) {
+		chprintf(SERIAL_OUT, "\r\nbenchmark FAILED : %d regression(s), %d case(s) without baseline\r\n", regressions, missing);
+		if(missing != 0) {
+			chprintf(SERIAL_OUT, "copy the lines above in bench_baseline.h to store the baseline\r\n");
+		}
+		return false;
+	}
+	chprintf(SERIAL_OUT, "\r\nbenchmark passed\r\n");
+	return true;
+}
@@ -0,0 +1,13 @@
+/*
+ * bench.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+bool benchmark_run(void);
+
+#endif /* BENCH_H_ */
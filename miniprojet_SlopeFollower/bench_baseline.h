@@ -0,0 +1,20 @@
+/*
+ * bench_baseline.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef BENCH_BASELINE_H_
+#define BENCH_BASELINE_H_
+
+#include <stdbool.h>
+
+// Reference results of the benchmark [ns/op] (see bench.c)
+// At the end of a run on the robot, the benchmark prints the #define BASELINE_* lines of the new results :
+// copy them here, under BENCH_BASELINE, and set it to true to store a new baseline
+// Without a stored baseline, the benchmark only measures : nothing is compared
+
+#define BENCH_BASELINE false // true once the results of a run on the robot are stored below
+
+#endif /* BENCH_BASELINE_H_ */
@@ -0,0 +1,295 @@
+/*
+ * blackbox.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <sensors/imu.h>
+#include <angle.h>
+#include <prox.h>
+#include <drive.h>
+#include <regulation.h>
+#include <executive.h>
+#include <flash.h>
+#include <blackbox.h>
+#include <timebase.h>
+
+/*
+ * Black box
+ * A decimated record of the robot is written in the flash while it runs : it is kept after a power cut
+ * and extracted by tools/blackbox.py
+ *
+ * Layout : BB_NB_SECTORS sectors used in turn as a circular log
+ *   the first block of a sector is its header (BB_MAGIC, sequence number), then records of one block (bb_record_t)
+ *   the sector with the biggest sequence number is being written, the next one is the oldest
+ * Wear leveling : a sector is only erased when the log goes around, all the sectors are erased in turn
+ * Power loss : the blocks are written one after the other and the check word of a record is programmed last,
+ * a power loss can only leave the last block incomplete. At the next boot, the writing continues after it
+ * An erase stops the program for 1 to 2 s, the motors are only stopped during the boot : the erases are done
+ * at the boot only. The sector after the one being written is kept erased (spare) : when the sector gets full
+ * during a run, the writing goes on in the spare without erase (only its header is programmed). At the boot, the
+ * spare is used if less than BB_MIN_FREE blocks are left, then the next sector is erased as the new spare.
+ * A run is recorded for at least BB_MIN_FREE + BB_BLOCKS - 2 blocks (BB_RUN_MIN, 10 min of samples without
+ * transitions), then the recording stops until the next boot. The log keeps the BB_NB_SECTORS - 1 last sectors.
+ * The linker must not place the program in these sectors : flash_reserve.ld makes the link fail if it does
+ */
+
+// customizable parameters
+
+#define BB_PERIOD 100 // period of the samples [ms]
+#define BB_MIN_FREE 2048 // blocks left in the sector at the boot under which the next sector is used (200 s of samples)
+
+// end of customizable parameters
+
+#define BB_FIRST_SECTOR 8 // sectors 8 to 10 of the STM32F407 (128 kB), the sector 11 is the calibration
+#define BB_NB_SECTORS 3
+#ifndef BLACKBOX_ADDRESS // the simulation gives its own sectors (see simulation/platform/hal_lld.h)
+#define BLACKBOX_ADDRESS 0x08080000 // beginning of the sector 8
+#endif
+
+#define BB_MAGIC 0x42424F58 // "BBOX", to change when bb_record_t changes
+#define BB_FORMAT 1 // version of the content of the records, given in the boot record
+#define BB_BLOCK_WORDS (sizeof(bb_record_t) / sizeof(uint32_t))
+#define BB_BLOCKS (FLASH_SECTOR_SIZE / sizeof(bb_record_t)) // blocks in a sector, header included
+#define BB_RUN_MIN ((BB_MIN_FREE + BB_BLOCKS - 2) * BB_PERIOD / 1000) // shortest run recorded entirely, without transitions [s]
+
+#define RAD_TO_DEG 57.2958f
+#define GYRO_AXIS 2
+
+// header of a sector
+typedef struct {
+	uint32_t magic;
+	uint32_t sequence;				// number of the sector since the first use of the black box
+	uint32_t unused[BB_BLOCK_WORDS - 2];
+} bb_header_t;
+
+static uint8_t sector = 0; // sector being written (0 to BB_NB_SECTORS - 1)
+static uint32_t sequence = 0; // sequence number of the sector being written
+static uint32_t block = 0; // next block to write in the sector
+static bool spare = false; // true if the next sector is erased : the writing can go on in it during the run
+static uint32_t transition = 0; // number of the next movement transition to record
+
+/*
+ * first word of a block of the black box
+ */
+static volatile uint32_t* block_address(uint8_t s, uint32_t b) {
+	return (volatile uint32_t*)(BLACKBOX_ADDRESS + s * FLASH_SECTOR_SIZE + b * sizeof(bb_record_t));
+}
+
+/*
+ * check word of a record : sum of its other words, mixed with the magic so that an erased block doesn't match
+ */
+static uint32_t check(const bb_record_t* record) {
+	const uint32_t* words = (const uint32_t*)record;
+	uint32_t sum = BB_MAGIC;
+
+	for(uint8_t i = 0 ; i < BB_BLOCK_WORDS - 1 ; i++) {
+		sum += words[i];
+	}
+	return sum;
+}
+
+static bool block_erased(uint8_t s, uint32_t b) {
+	volatile uint32_t* words = block_address(s, b);
+
+	for(uint8_t i = 0 ; i < BB_BLOCK_WORDS ; i++) {
+		if(words[i] != FLASH_ERASED) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * erases a sector if a word of it isn't erased
+ * stops the program for 1 to 2 s : only during the boot, while the motors are stopped
+ *
+ * \return		true if the sector is erased
+ */
+static bool sector_erase(uint8_t s) {
+	volatile uint32_t* words = block_address(s, 0);
+	bool ok = true;
+
+	for(uint32_t i = 0 ; i < FLASH_SECTOR_SIZE / sizeof(uint32_t) ; i++) {
+		if(words[i] != FLASH_ERASED) {
+			flash_unlock();
+			ok = flash_erase(BB_FIRST_SECTOR + s);
+			flash_lock();
+			break;
+		}
+	}
+	return ok;
+}
+
+/*
+ * starts writing an erased sector : writes its header
+ * stops the program for about 32 us, can be done during the run
+ */
+static void sector_start(uint8_t s, uint32_t number) {
+	volatile uint32_t* words = block_address(s, 0);
+
+	flash_unlock();
+	flash_program(&words[0], BB_MAGIC);
+	flash_program(&words[1], number);
+	flash_lock();
+
+	sector = s;
+	sequence = number;
+	block = 1;
+}
+
+/*
+ * finds where the writing continues : first erased block of the newest sector
+ * a block partly written by a power loss is not erased, it is skipped
+ * goes to the next sector if the newest one is almost full, then erases the spare
+ */
+static void blackbox_open(void) {
+	const bb_header_t* header = NULL;
+	bool found = false;
+	uint32_t newest = 0;
+
+	for(uint8_t s = 0 ; s < BB_NB_SECTORS ; s++) {
+		header = (const bb_header_t*)block_address(s, 0);
+		// the sequence numbers are compared with their difference : the wrap around is handled
+		if(header->magic == BB_MAGIC && (!found || (int32_t)(header->sequence - newest) > 0)) {
+			found = true;
+			newest = header->sequence;
+			sector = s;
+		}
+	}
+
+	if(!found) {
+		sector_erase(0);
+		sector_start(0, 0);
+	} else {
+		sequence = newest;
+		// the blocks are written in order : the end of the log is after the last block not erased
+		block = BB_BLOCKS;
+		while(block > 1 && block_erased(sector, block - 1)) {
+			block--;
+		}
+
+		if(BB_BLOCKS - block < BB_MIN_FREE) {
+			sector_erase((sector + 1) % BB_NB_SECTORS); // the spare, not erased anymore if the last run used it
+			sector_start((sector + 1) % BB_NB_SECTORS, newest + 1);
+		}
+	}
+
+	// the oldest sector becomes the spare of this run
+	spare = sector_erase((sector + 1) % BB_NB_SECTORS);
+}
+
+/*
+ * writes a record in the next block, the check word last
+ * goes on in the spare when the sector is full
+ * stops the program for about 16 us per word
+ *
+ * \return		false if the sector is full and the spare already used
+ */
+static bool blackbox_write(bb_record_t* record) {
+	const uint32_t* words = (const uint32_t*)record;
+	volatile uint32_t* address = NULL;
+
+	if(block >= BB_BLOCKS) {
+		if(!spare) {
+			return false;
+		}
+		sector_start((sector + 1) % BB_NB_SECTORS, sequence + 1);
+		spare = false;
+	}
+	address = block_address(sector, block);
+	record->check = check(record);
+
+	flash_unlock();
+	for(uint8_t i = 0 ; i < BB_BLOCK_WORDS ; i++) {
+		if(!flash_program(&address[i], words[i])) {
+			break; // the block stays incomplete, the decoder skips it
+		}
+	}
+	flash_lock();
+
+	block++;
+	return true;
+}
+
+/*
+ * decimated state of the robot
+ */
+static void blackbox_sample(bb_record_t* record) {
+	regul_terms_t terms;
+	release_stats_t regul;
+
+	get_regulator_terms(&terms);
+	get_release_stats(TASK_REGUL, &regul);
+
+	record->type = BB_SAMPLE;
+	record->data[BB_HEADING] = get_angle();
+	record->data[BB_INCLINATION] = get_inclination();
+	record->data[BB_PROX_ALERT] = get_prox_alert();
+	record->data[BB_PROX_MAX] = get_prox_max();
+	record->data[BB_PROP] = terms.prop;
+	record->data[BB_INTEGR] = terms.integr;
+	record->data[BB_DERIV] = terms.deriv;
+	record->data[BB_LINEAR] = drive_get_linear();
+	record->data[BB_ANGULAR] = drive_get_angular();
+	record->data[BB_GYRO] = get_gyro_rate(GYRO_AXIS) * RAD_TO_DEG * 10;
+	record->data[BB_JITTER] = regul.jitter_max;
+}
+
+/*
+ * thread of the black box, lowest priority of the robot : the samples wait for the control
+ * records the movement transitions taken since the last period, then a sample
+ */
+static THD_WORKING_AREA(blackbox_thd_wa, 512);
+static THD_FUNCTION(blackbox_thd, arg) {
+
+	chRegSetThreadName(__FUNCTION__);
+	(void) arg;
+
+	systime_t time = chVTGetSystemTime();
+	bb_record_t record = {0};
+	fsm_log_t entry;
+	bool room = true; // false when the sector and the spare are full
+
+	record.type = BB_BOOT;
+	record.time = timebase_ms();
+	record.data[0] = BB_FORMAT;
+	room = blackbox_write(&record);
+
+	while(room) {
+		for( ; motion_get_transition(&transition, &entry) ; transition++) {
+			record = (bb_record_t){0};
+			record.time = entry.time;
+			record.type = BB_TRANSITION;
+			record.state = entry.to;
+			record.data[0] = entry.from;
+			record.data[1] = entry.to;
+			record.data[2] = entry.event;
+			room = room && blackbox_write(&record);
+		}
+
+		record = (bb_record_t){0};
+		record.time = timebase_ms();
+		record.state = motion_get_state();
+		blackbox_sample(&record);
+		room = room && blackbox_write(&record);
+
+		chThdSleepUntilWindowed(time, time + MS2ST(BB_PERIOD));
+		time += MS2ST(BB_PERIOD);
+	}
+	// after BB_RUN_MIN at least : the recording stops until the next boot, where the spare is erased
+}
+
+/*
+ * opens the log (erases the spare if needed) and starts the recording
+ * only to call during the boot, before the motors start (the flash is blocked during an erase)
+ */
+void blackbox_start(void) {
+	blackbox_open();
+	chThdCreateStatic(blackbox_thd_wa, sizeof(blackbox_thd_wa), NORMALPRIO - 1, blackbox_thd, NULL);
+}
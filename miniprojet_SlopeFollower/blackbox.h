@@ -0,0 +1,45 @@
+/*
+ * blackbox.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef BLACKBOX_H_
+#define BLACKBOX_H_
+
+#include <hal.h>
+
+#define BLACKBOX true // true to record the sensors, the estimations and the regulation in the flash (decoded by tools/blackbox.py)
+
+// kinds of records
+#define BB_BOOT 1			// start of the recording, data[0] is BB_FORMAT
+#define BB_SAMPLE 2			// decimated state of the robot, see BB_* indexes
+#define BB_TRANSITION 3		// movement state change : data[0] from, data[1] to, data[2] event
+
+// content of a sample
+#define BB_HEADING 0		// [0.01 deg]
+#define BB_INCLINATION 1
+#define BB_PROX_ALERT 2
+#define BB_PROX_MAX 3
+#define BB_PROP 4			// regulator terms [step/s]
+#define BB_INTEGR 5
+#define BB_DERIV 6
+#define BB_LINEAR 7			// speeds applied by the drive [step/s]
+#define BB_ANGULAR 8
+#define BB_GYRO 9			// yaw rate, positive to the right [0.1 deg/s]
+#define BB_JITTER 10		// biggest jitter of the regulation since the start [us]
+#define BB_NB_DATA 11
+
+// record, 32 bytes : one block of the flash
+typedef struct {
+	uint32_t time;					// [ms] since the start
+	uint8_t type;					// BB_BOOT, BB_SAMPLE or BB_TRANSITION
+	uint8_t state;					// movement state
+	int16_t data[BB_NB_DATA];
+	uint32_t check;					// programmed last : a record cut by a power loss doesn't match
+} bb_record_t;
+
+void blackbox_start(void);
+
+#endif /* BLACKBOX_H_ */
@@ -0,0 +1,128 @@
+/*
+ * boot.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <chprintf.h>
+#include <boot.h>
+
+/*
+ * Boot sequencer
+ * Each phase runs in a worker thread as soon as the phases it depends on are ready,
+ * so the independent phases (the calibrations) run at the same time
+ */
+
+#define BOOT_WORKERS 2 // phases running at the same time at most
+
+// worker thread running a phase
+typedef struct {
+	stkalign_t* wa;				// working area of the thread
+	size_t wa_size;
+	thread_t* tp;				// NULL if the worker is free
+	boot_phase_t* phase;		// phase being run
+	uint8_t number;				// number of the phase
+	thread_t* sequencer;		// thread to signal at the end of the phase
+	eventmask_t event;			// event signaled at the end of the phase
+} boot_worker_t;
+
+static THD_WORKING_AREA(boot_worker_1_wa, 512);
+static THD_WORKING_AREA(boot_worker_2_wa, 512);
+
+static boot_worker_t workers[BOOT_WORKERS] = {
+	{boot_worker_1_wa, sizeof(boot_worker_1_wa), NULL, NULL, 0, NULL, EVENT_MASK(0)},
+	{boot_worker_2_wa, sizeof(boot_worker_2_wa), NULL, NULL, 0, NULL, EVENT_MASK(1)},
+};
+
+/*
+ * worker thread : runs one phase and signals the sequencer
+ */
+static THD_FUNCTION(boot_worker, arg){
+
+	boot_worker_t* worker = arg;
+
+	chRegSetThreadName(worker->phase->name);
+
+	worker->phase->run();
+	worker->phase->end = chVTGetSystemTime();
+
+	chEvtSignal(worker->sequencer, worker->event);
+}
+
+/*
+ * runs the phases according to their dependencies, returns when all of them are ready
+ * the dependencies must not have cycles
+ *
+ * \param phases		table of the phases (16 at most)
+ *
+ * \param nb_phases		number of phases
+ */
+void boot_run(boot_phase_t* phases, uint8_t nb_phases) {
+	uint16_t all = (1 << nb_phases) - 1;
+	uint16_t started = 0; // BOOT_DEP() of the phases started
+	uint16_t ready = 0; // BOOT_DEP() of the phases finished
+	eventmask_t events = 0;
+
+	while(ready != all) {
+
+		// starts every phase whose dependencies are ready, while a worker is free
+		for(uint8_t i = 0 ; i < nb_phases ; i++) {
+			if((started & BOOT_DEP(i)) || (phases[i].depends & ready) != phases[i].depends) {
+				continue;
+			}
+			for(uint8_t w = 0 ; w < BOOT_WORKERS ; w++) {
+				if(workers[w].tp == NULL) {
+					workers[w].phase = &phases[i];
+					workers[w].number = i;
+					workers[w].sequencer = chThdGetSelfX();
+					phases[i].start = chVTGetSystemTime();
+					workers[w].tp = chThdCreateStatic(workers[w].wa, workers[w].wa_size, NORMALPRIO, boot_worker, &workers[w]);
+					started |= BOOT_DEP(i);
+					break;
+				}
+			}
+		}
+
+		chDbgAssert(started != ready, "boot phases can't start");
+
+		// end of one or more phases, their workers are free again
+		events = chEvtWaitAny(ALL_EVENTS);
+		for(uint8_t w = 0 ; w < BOOT_WORKERS ; w++) {
+			if((events & workers[w].event) && workers[w].tp != NULL) {
+				chThdWait(workers[w].tp);
+				workers[w].tp = NULL;
+				ready |= BOOT_DEP(workers[w].number);
+			}
+		}
+	}
+}
+
+/*
+ * sends the start and the duration of each phase
+ * the time is counted from the start of the first phase
+ *
+ * \param out			stream to write to (serial port)
+ *
+ * \param phases		table of the phases, after boot_run()
+ *
+ * \param nb_phases		number of phases
+ */
+void boot_print(BaseSequentialStream* out, const boot_phase_t* phases, uint8_t nb_phases) {
+	systime_t origin = phases[0].start;
+	systime_t end = phases[0].end;
+
+	chprintf(out, "\r\nboot :\r\n");
+	for(uint8_t i = 0 ; i < nb_phases ; i++) {
+		chprintf(out, "%-12s start %5u ms  duration %5u ms\r\n", phases[i].name,
+				ST2MS(phases[i].start - origin), ST2MS(phases[i].end - phases[i].start));
+		if(phases[i].end - origin > end - origin) {
+			end = phases[i].end;
+		}
+	}
+	chprintf(out, "total        %u ms\r\n", ST2MS(end - origin));
+}
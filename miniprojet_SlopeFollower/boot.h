@@ -0,0 +1,27 @@
+/*
+ * boot.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef BOOT_H_
+#define BOOT_H_
+
+#include <hal.h>
+
+#define BOOT_DEP(phase) (1 << (phase)) // dependency on a phase, to combine with |
+
+// step of the boot
+typedef struct {
+	const char* name;		// name of the phase (also the name of the thread running it)
+	void (*run)(void);		// returns when what the phase starts is ready
+	uint16_t depends;		// BOOT_DEP() of the phases that must be ready before this one
+	systime_t start;		// filled by the sequencer
+	systime_t end;			// filled by the sequencer
+} boot_phase_t;
+
+void boot_run(boot_phase_t* phases, uint8_t nb_phases);
+void boot_print(BaseSequentialStream* out, const boot_phase_t* phases, uint8_t nb_phases);
+
+#endif /* BOOT_H_ */
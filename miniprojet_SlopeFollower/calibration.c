@@ -0,0 +1,178 @@
+/*
+ * calibration.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <ch.h>
+#include <hal.h>
+#include <sensors/imu.h>
+#include <sensors/proximity.h>
+#include <calibration.h>
+#include <flash.h>
+
+/*
+ * Persistent calibration
+ * The accelerometer offsets and the proximity sensors ambient values are stored in the last sector of the flash
+ * At the next boot, they are used again if they are still valid (see calibration_load()) : the robot starts without calibrating
+ *
+ * Sector layout :
+ *   calibration_t at the beginning of the sector
+ *   then one word per warm boot, programmed to 0 at each boot without calibration (age of the calibration)
+ * The linker must not place the program in this sector : flash_reserve.ld makes the link fail if it does
+ */
+
+// customizable parameters
+
+#define CALIB_MAX_BOOTS 50 // number of warm boots before a new calibration is needed
+#define CALIB_MAX_TEMP_DELTA 5 // temperature difference with the calibration [deg C] above which a new calibration is needed
+
+// end of customizable parameters
+
+#define CALIB_SECTOR 11 // last sector of the STM32F407 (128 kB)
+#ifndef CALIB_ADDRESS // the simulation gives its own sector (see simulation/platform/hal_lld.h)
+#define CALIB_ADDRESS 0x080E0000 // beginning of the sector
+#endif
+#define CALIB_SECTOR_SIZE FLASH_SECTOR_SIZE
+#define BOOTS_OFFSET 256 // position of the boot counter words in the sector [byte]
+
+#define CALIB_MAGIC 0x43414C31 // "CAL1", to change when calibration_t changes
+
+#define NB_AXIS 3
+
+// content of the flash sector
+typedef struct {
+	uint32_t magic;					// CALIB_MAGIC if the sector has been written
+	int16_t acc_offset[NB_AXIS];	// offset of the accelerometer
+	int16_t ir_offset[NB_IR];		// ambient value of the proximity sensors
+	int16_t unused;					// alignment, part of the checksum
+	float temperature;				// temperature of the IMU during the calibration [deg C]
+	uint32_t checksum;				// sum of the previous words
+} calibration_t;
+
+static calibration_t calib = {0}; // calibration in use
+
+static volatile uint32_t* const boots = (uint32_t*)(CALIB_ADDRESS + BOOTS_OFFSET);
+#define NB_BOOTS ((CALIB_SECTOR_SIZE - BOOTS_OFFSET) / sizeof(uint32_t))
+
+/*
+ * checksum of a calibration : sum of all the words except the checksum
+ */
+static uint32_t checksum(const calibration_t* c) {
+	const uint32_t* words = (const uint32_t*)c;
+	uint32_t sum = 0;
+
+	for(uint8_t i = 0 ; i < offsetof(calibration_t, checksum) / sizeof(uint32_t) ; i++) {
+		sum += words[i];
+	}
+	return sum;
+}
+
+/*
+ * loads the stored calibration and checks it
+ * valid if : it has been written and isn't corrupted, it has been used for less than CALIB_MAX_BOOTS boots,
+ * and the IMU temperature is close to the one of the calibration
+ * the IMU must be started
+ * a valid calibration gets one boot older
+ *
+ * \return		true if the stored calibration can be used
+ */
+bool calibration_load(void) {
+	const calibration_t* stored = (const calibration_t*)CALIB_ADDRESS;
+	uint32_t age = 0;
+
+	if(stored->magic != CALIB_MAGIC || stored->checksum != checksum(stored)) {
+		return false;
+	}
+
+	// age of the calibration : first word not programmed yet
+	while(age < NB_BOOTS && boots[age] != FLASH_ERASED) {
+		age++;
+	}
+	if(age >= CALIB_MAX_BOOTS) {
+		return false;
+	}
+
+	if(fabsf(get_temperature() - stored->temperature) > CALIB_MAX_TEMP_DELTA) {
+		return false;
+	}
+
+	calib = *stored;
+
+	flash_unlock();
+	flash_program(&boots[age], 0);
+	flash_lock();
+
+	return true;
+}
+
+/*
+ * keeps the accelerometer offsets of the last calibrate_acc() and the IMU temperature
+ */
+void calibration_store_acc(void) {
+	for(uint8_t i = 0 ; i < NB_AXIS ; i++) {
+		calib.acc_offset[i] = get_acc_offset(i);
+	}
+	calib.temperature = get_temperature();
+}
+
+/*
+ * keeps the ambient values of the last calibrate_ir()
+ * the library only gives the calibrated value : the ambient value is the difference with the raw value
+ */
+void calibration_store_ir(void) {
+	for(uint8_t i = 0 ; i < NB_IR ; i++) {
+		chSysLock(); // both values must come from the same measurement
+		calib.ir_offset[i] = get_prox(i) - get_calibrated_prox(i);
+		chSysUnlock();
+	}
+}
+
+/*
+ * writes the calibration in the flash, which resets its age
+ * the sector erase blocks the flash (about 1 s) : only to call during the boot, before the motors start
+ */
+void calibration_save(void) {
+	const uint32_t* words = (const uint32_t*)&calib;
+
+	calib.magic = CALIB_MAGIC;
+	calib.checksum = checksum(&calib);
+
+	flash_unlock();
+
+	if(flash_erase(CALIB_SECTOR)) {
+		for(uint8_t i = 0 ; i < sizeof(calibration_t) / sizeof(uint32_t) ; i++) {
+			if(!flash_program((volatile uint32_t*)CALIB_ADDRESS + i, words[i])) {
+				break;
+			}
+		}
+	}
+
+	flash_lock();
+}
+
+/*
+ * allows to get the accelerometer offset in another file
+ *
+ * \param axis		X_AXIS, Y_AXIS or Z_AXIS
+ *
+ * \return			offset to remove from get_acc()
+ */
+int16_t get_acc_calibration(uint8_t axis) {
+	return calib.acc_offset[axis];
+}
+
+/*
+ * allows to get the ambient value of a proximity sensor in another file
+ *
+ * \param sensor	number of the sensor (0 to 7)
+ *
+ * \return			value to remove from get_prox()
+ */
+int16_t get_ir_calibration(uint8_t sensor) {
+	return calib.ir_offset[sensor];
+}
@@ -0,0 +1,20 @@
+/*
+ * calibration.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef CALIBRATION_H_
+#define CALIBRATION_H_
+
+#define NB_IR 8 // number of proximity sensors
+
+bool calibration_load(void);
+void calibration_store_acc(void);
+void calibration_store_ir(void);
+void calibration_save(void);
+int16_t get_acc_calibration(uint8_t axis);
+int16_t get_ir_calibration(uint8_t sensor);
+
+#endif /* CALIBRATION_H_ */
@@ -439,8 +439,18 @@
  * @brief   Context switch hook.
  * @details This hook is invoked just before switching between threads.
  */
+#define TRACE_DUMP FALSE // TRUE to record the context switches and send the scheduler trace on the serial port (trace.c)
+
+#if !defined(_FROM_ASM_)
+void trace_switch(void* ntp, void* otp);
+#endif
+
+/* TRUE and FALSE are only defined after this file (chtypes.h) : TRACE_DUMP is tested in the hook, not by #if */
 #define CH_CFG_CONTEXT_SWITCH_HOOK(ntp, otp) {                              \
         /* Context switch code here.*/                                            \
+        if(TRACE_DUMP) {                                                          \
+          trace_switch(ntp, otp);                                                 \
+        }                                                                         \
 }
 
 /**
@@ -488,6 +498,7 @@
 extern "C" {
 #endif
 void panic_handler(const char *reason);
+void trace_switch(void *ntp, void *otp);
 #ifdef __cplusplus
 }
 #endif
@@ -507,6 +518,9 @@ void panic_handler(const char *reason);
 // chprintf float enable
 #define CHPRINTF_USE_FLOAT true
 
+// the idle thread stops the core until the next interrupt (time freed by the adaptive angle period)
+#define CORTEX_ENABLE_WFI_IDLE TRUE
+
 #endif  /* _CHCONF_H_ */
 
 /** @} */
@@ -0,0 +1,206 @@
+/*
+ * control.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <control.h>
+
+/*
+ * Control laws of the movement, without ChibiOS : the state is given by the caller
+ * Shared by the firmware (regulation.c, drive.c) and the batch simulation (simulation/batch.c) : both run the same code
+ */
+
+#define DERIV_FILTER ((float)DERIV_TAU / (DERIV_TAU + REGUL_PERIOD)) // pole of the filter of the derivative term
+
+/*
+ * PI regulator (PID with the derivative term when PID is true)
+ * input : slope direction (angle) relative to the front of the robot
+ * output : speed difference to apply to the motors
+ * A variable speed diference signify controllable turns
+ *
+ * \param regul				state of the regulator, started with REGUL_INIT
+ *
+ * \param mesured_angle		slope angle measured by the angle thread [heading]
+ *
+ * \param angle_to_reach	angle to reach [heading]
+ *
+ * \param mode				REGUL_RUN, REGUL_RESET (small slope : all the terms to 0)
+ * 							or REGUL_RESUME (first period after another mode : bumpless transfer)
+ *
+ * \return					speed difference to apply to the motors
+ */
+int16_t regulator_step(regul_t* regul, heading_t mesured_angle, heading_t angle_to_reach, uint8_t mode) {
+	heading_t err = 0; // angle error
+	float prop = 0; // proportional term, float because order depends on the KP
+	float output = 0; // sum of the terms, before the limits
+	float clamped = 0; // output within the limits, before the conversion
+	int16_t delta_speed = 0; // output to compute
+
+	err = heading_diff(mesured_angle, angle_to_reach);
+
+	// the first period on the slope after a small slope is also a change of mode
+	if(mode == REGUL_RUN && regul->mode_last == REGUL_RESET) {
+		mode = REGUL_RESUME;
+	}
+	regul->mode_last = mode;
+
+	// bumpless transfer : the integral term is kept (it doesn't depend on the heading)
+	// and the derivative doesn't see the heading jump of the escape maneuver or of the small slope
+	if(mode != REGUL_RUN) {
+		regul->deriv = 0;
+		regul->angle_last = mesured_angle;
+	}
+	// the error alone can't tell a small slope : with sub-degree headings, it is rarely exactly 0
+	if(mode == REGUL_RESET) {
+		regul->integr = 0;
+	}
+
+	prop = KP * (float)err / HEADING_SCALE;
+	// the integral term only corrects the small errors : accumulated during a turn, it made the robot overshoot
+	// by 16 deg, without saturation of the output for the ARW to see it
+	if(KI != 0 && abs(err) < INTEGR_BAND * HEADING_SCALE) { // useless if KI = 0
+		regul->integr += KI * (float)err / HEADING_SCALE;
+	}
+	if(PID) {
+		// derivative of the measurement and not of the error : no kick when the angle to reach changes
+		// filtered by a first order, the angle is noisy
+		regul->deriv = DERIV_FILTER * regul->deriv + (1 - DERIV_FILTER) * KD
+				* (float)heading_diff(mesured_angle, regul->angle_last) * 1000 / (HEADING_SCALE * REGUL_PERIOD);
+		regul->angle_last = mesured_angle;
+	}
+
+	output = prop + regul->integr + regul->deriv; // commands computation
+
+	// limits management, in float : the conversion to int16_t isn't an excess over the limit
+	if (output > SPEED_MAX) {
+		clamped = SPEED_MAX;
+	} else if (output < -SPEED_MAX) {
+		clamped = -SPEED_MAX;
+	} else {
+		clamped = output;
+	}
+	delta_speed = clamped;
+
+	// ARW by back-calculation, useless if KI = 0
+	// in saturation, the integral term is pulled back by a part of the excess over the limit, 0 out of saturation
+	// but not beyond 0 : the excess of the proportional term isn't a windup, an integral term of the opposite sign
+	// would cancel it and the robot would turn slowly until it unwinds (180 deg flip 6 times longer with KP 10)
+	if ((ARW == true) && (KI != 0) && (clamped != output)) {
+		float integr_last = regul->integr;
+
+		regul->integr += KAW * (clamped - output);
+		if ((regul->integr > 0) != (integr_last > 0)) {
+			regul->integr = 0;
+		}
+	}
+
+	regul->terms.prop = prop;
+	regul->terms.integr = regul->integr;
+	regul->terms.deriv = regul->deriv;
+
+	return delta_speed;
+}
+
+/*
+ * position of a value between two limits
+ *
+ * \return		0 under low, 1 above high, linear between them
+ */
+static float ratio(int32_t value, int32_t low, int32_t high) {
+	if(value <= low) {
+		return 0;
+	} else if(value >= high) {
+		return 1;
+	}
+	return (float)(value - low) / (high - low);
+}
+
+/*
+ * cruise speed scheduling
+ * the speed goes from SPEED_CRUISE_MAX to SPEED_CRUISE_MIN with the most limiting of the slope,
+ * the heading error and the proximity of an obstacle, the slope alone doesn't go under SPEED_STEEP
+ * it is then limited so that both wheels stay under SPEED_MAX with the speed difference :
+ * the regulator output is always applied entirely
+ *
+ * \param err				heading error [heading]
+ *
+ * \param delta_speed		speed difference that will be applied to the motors
+ *
+ * \param inclination		averaged acceleration on the Z axis (estimate_t)
+ *
+ * \param prox				biggest value of the proximity sensors
+ *
+ * \return					cruise speed [step/s]
+ */
+int16_t speed_schedule(heading_t err, int16_t delta_speed, int16_t inclination, int16_t prox) {
+	float slow = 0; // 0 : fastest, 1 : slowest
+	float slow_err = ratio(abs(err), ERR_SMALL * HEADING_SCALE, ERR_BIG * HEADING_SCALE);
+	float slow_prox = ratio(prox, PROX_FAR, PROX_CLOSE);
+	int16_t speed = 0;
+
+	if(!SPEED_SCHEDULING) {
+		return SPEED_MOY;
+	}
+
+	slow = ratio(inclination, INCL_GENTLE, INCL_STEEP) * SLOW_STEEP; // down to SPEED_STEEP
+	slow = (slow_err > slow) ? slow_err : slow;
+	slow = (slow_prox > slow) ? slow_prox : slow;
+
+	speed = SPEED_CRUISE_MAX - slow * (SPEED_CRUISE_MAX - SPEED_CRUISE_MIN);
+
+	// keeps the wheels out of saturation
+	if(speed > SPEED_MAX - abs(delta_speed)) {
+		speed = SPEED_MAX - abs(delta_speed);
+	}
+
+	return speed;
+}
+
+/*
+ * moves the speed of one axis toward its command
+ * the acceleration is chosen so that it can come back to 0 with the maximum jerk when the command is reached :
+ * acc = sqrt(2 * jerk * |error|), limited to acc_max, and it changes by at most jerk * dt
+ *
+ * \param axis			axis to update
+ *
+ * \param acc_max		maximum acceleration [step/s^2]
+ *
+ * \param jerk_max		maximum jerk [step/s^3]
+ *
+ * \param dt			time since the last update [s]
+ */
+void axis_update(axis_t* axis, float acc_max, float jerk_max, float dt) {
+	float err = axis->command - axis->speed;
+	float acc_wanted = 0;
+	float acc_step = jerk_max * dt;
+
+	acc_wanted = sqrtf(2 * jerk_max * fabsf(err));
+	if(acc_wanted > acc_max) {
+		acc_wanted = acc_max;
+	}
+	if(err < 0) {
+		acc_wanted = -acc_wanted;
+	}
+
+	// jerk limit
+	if(acc_wanted > axis->acc + acc_step) {
+		axis->acc += acc_step;
+	} else if(acc_wanted < axis->acc - acc_step) {
+		axis->acc -= acc_step;
+	} else {
+		axis->acc = acc_wanted;
+	}
+
+	axis->speed += axis->acc * dt;
+
+	// the command is reached or passed
+	if((err >= 0 && axis->speed >= axis->command) || (err <= 0 && axis->speed <= axis->command)) {
+		axis->speed = axis->command;
+		axis->acc = 0;
+	}
+}
@@ -0,0 +1,96 @@
+/*
+ * control.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef CONTROL_H_
+#define CONTROL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <estimate.h>
+
+// customizable parameters
+
+// regulator constants, for an error of one degree
+#define KP 5
+#define KI 0.02
+#define INTEGR_BAND 5 // heading error [deg] above which the integral term isn't accumulated
+
+#define PID false // true to add the filtered derivative term to the PI regulator
+#define KD 0.5 // derivative constant, for an angle changing by one degree per second [step/s]
+#define DERIV_TAU 40 // time constant of the filter of the derivative term [ms]
+
+#define ARW true // true to activate the Anti Reset Windup (back-calculation)
+#define KAW 0.5 // ARW : part of the excess over the limit removed from the integral term at each period, down to 0
+
+#define AVERAGE_SIZE_SPEED 10 // size of the moving average for the speed command
+
+// cruise speed scheduling
+#define SPEED_SCHEDULING true // true to adapt the cruise speed to the slope, false for a fixed SPEED_MOY
+#define SPEED_CRUISE_MAX 800 // cruise speed on a gentle slope, aligned and far from obstacles [step/s]
+#define SPEED_CRUISE_MIN 300 // cruise speed with a big heading error or close to an obstacle [step/s]
+#define SPEED_STEEP SPEED_MOY // cruise speed on a steep slope : the fixed speed of the robot on all the slopes [step/s]
+#define INCL_GENTLE 300 // inclination under which the slope is gentle (INCL_LIMIT)
+#define INCL_STEEP 2200 // inclination above which the slope is steep (about 30 deg)
+#define ERR_SMALL 5 // heading error [deg] under which the robot is aligned
+#define ERR_BIG 60 // heading error [deg] above which the robot is slowest
+#define PROX_FAR 200 // proximity under which there is no obstacle
+#define PROX_CLOSE 600 // proximity at which the robot is slowest (PROXIMITY_TRESHOLD)
+
+// limits of the linear speed (drive.c)
+#define ACC_MAX_LINEAR 4000 // [step/s^2]
+#define JERK_MAX_LINEAR 40000 // [step/s^3]
+
+// limits of the angular speed (drive.c)
+#define ACC_MAX_ANGULAR 8000 // [step/s^2]
+#define JERK_MAX_ANGULAR 80000 // [step/s^3]
+
+// end of customizable parameters
+
+// time to execute thread content : measured by the benchmark (see bench.c)
+// period of the regulation thread [ms]
+#define REGUL_PERIOD 10
+
+#define SPEED_MAX  1000 // wheels maximum speed [step/s]
+#define SPEED_MOY (SPEED_MAX/2) // wheel average speed during the normal operations, without speed scheduling
+// part of the slowing down (SPEED_CRUISE_MAX to SPEED_CRUISE_MIN) given by a steep slope
+#define SLOW_STEEP ((float)(SPEED_CRUISE_MAX - SPEED_STEEP) / (SPEED_CRUISE_MAX - SPEED_CRUISE_MIN))
+
+// modes of the regulator
+#define REGUL_RUN 0 // normal period
+#define REGUL_RESET 1 // the heading isn't defined (small slope) : all the terms to 0
+#define REGUL_RESUME 2 // first period after another mode : bumpless transfer
+
+// terms of the regulator at its last period [step/s]
+typedef struct {
+	int16_t prop;
+	int16_t integr;
+	int16_t deriv;
+} regul_terms_t;
+
+// state of the regulator, kept between two periods
+typedef struct {
+	float integr;			// integral term, float because order depends on the KI
+	float deriv;			// filtered derivative term
+	heading_t angle_last;	// angle measured at the last period, for the derivative
+	uint8_t mode_last;
+	regul_terms_t terms;	// terms of the last period
+} regul_t;
+
+#define REGUL_INIT {.mode_last = REGUL_RESET}
+
+// state of one axis of the drive (linear or angular)
+typedef struct {
+	float command;	// speed to reach [step/s]
+	float speed;	// current speed [step/s]
+	float acc;		// current acceleration [step/s^2]
+} axis_t;
+
+int16_t regulator_step(regul_t* regul, heading_t mesured_angle, heading_t angle_to_reach, uint8_t mode);
+int16_t speed_schedule(heading_t err, int16_t delta_speed, int16_t inclination, int16_t prox);
+void axis_update(axis_t* axis, float acc_max, float jerk_max, float dt);
+
+#endif /* CONTROL_H_ */
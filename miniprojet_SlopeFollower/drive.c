@@ -0,0 +1,91 @@
+/*
+ * drive.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <ch.h>
+#include <motors.h>
+#include <control.h>
+#include <drive.h>
+
+/*
+ * Differential drive command
+ * The movement is given as a linear speed and an angular speed (speed difference between the wheels) :
+ * left wheel = linear + angular ; right wheel = linear - angular
+ * Both speeds follow their command with limited acceleration and jerk, so that the steppers never lose steps
+ * on a reversal, and both wheels are written together
+ */
+
+// customizable parameters
+
+#define LIMITS true // true to limit the acceleration and the jerk (ACC_MAX_* and JERK_MAX_* in control.h), false to apply the commands directly
+
+// end of customizable parameters
+
+static axis_t linear_axis = {0};
+static axis_t angular_axis = {0};
+
+/*
+ * sets the movement to reach, applied progressively by drive_update()
+ *
+ * \param linear		linear speed [step/s]
+ *
+ * \param angular		angular speed, positive to turn right [step/s]
+ */
+void drive_set_command(int16_t linear, int16_t angular) {
+	chSysLock();
+	linear_axis.command = linear;
+	angular_axis.command = angular;
+	chSysUnlock();
+}
+
+/*
+ * allows to get the speed difference applied to the wheels in another file
+ *
+ * \return		angular speed after the limits, positive to turn right [step/s]
+ */
+int16_t drive_get_angular(void) {
+	return angular_axis.speed;
+}
+
+/*
+ * allows to get the mean speed of the wheels in another file
+ *
+ * \return		linear speed after the limits [step/s]
+ */
+int16_t drive_get_linear(void) {
+	return linear_axis.speed;
+}
+
+/*
+ * updates the speeds and commits them to both wheels, to call periodically
+ * the two motors are written in a critical zone : no thread can run between the two updates
+ *
+ * \param period		time since the last call [ms]
+ */
+void drive_update(uint16_t period) {
+	float dt = period / 1000.f;
+	int16_t left_speed = 0;
+	int16_t right_speed = 0;
+
+	chSysLock();
+	if(LIMITS) {
+		axis_update(&linear_axis, ACC_MAX_LINEAR, JERK_MAX_LINEAR, dt);
+		axis_update(&angular_axis, ACC_MAX_ANGULAR, JERK_MAX_ANGULAR, dt);
+	} else {
+		linear_axis.speed = linear_axis.command;
+		angular_axis.speed = angular_axis.command;
+	}
+	left_speed = linear_axis.speed + angular_axis.speed;
+	right_speed = linear_axis.speed - angular_axis.speed;
+
+	// the motor library only writes the step timers
+	left_motor_set_speed(left_speed);
+	right_motor_set_speed(right_speed);
+	chSysUnlock();
+}
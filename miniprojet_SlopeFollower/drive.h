@@ -0,0 +1,16 @@
+/*
+ * drive.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef DRIVE_H_
+#define DRIVE_H_
+
+void drive_set_command(int16_t linear, int16_t angular);
+void drive_update(uint16_t period);
+int16_t drive_get_angular(void);
+int16_t drive_get_linear(void);
+
+#endif /* DRIVE_H_ */
@@ -0,0 +1,121 @@
+/*
+ * estimate.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <average.h>
+#include <estimate.h>
+
+/*
+ * Estimation of the slope from the accelerations, without ChibiOS
+ * Shared by the firmware (angle.c) and the batch simulation (simulation/batch.c) : both run the same code
+ */
+
+#define PI 3.14159f
+
+// accelerometer axis
+#define X_AXIS 0
+#define Y_AXIS 1
+#define Z_AXIS 2
+
+/*
+ * computes the slope angle from the X and Y accelerations according to the defined convention (left : [-180 deg, 0 deg[ ; right : ]0 deg, +180 deg])
+ *
+ *         BACK
+ *         ####
+ *      #180/-180#
+ *    #            #
+ * R # 90  TOP  -90 # L
+ *    #    VIEW    #
+ *      #   0    #
+ *         ####
+ *         FRONT
+ *
+ * The slope angle is the direction of descending slope in an inclined plane
+ *
+ * \param acc_x		acceleration on the X axis, offset removed
+ *
+ * \param acc_y		acceleration on the Y axis, offset removed
+ *
+ * \return			computed angle [heading]
+ */
+heading_t slope_angle(int16_t acc_x, int16_t acc_y) {
+
+	heading_t angle = 0; // computed angle
+
+	angle = roundf((HEADING_HALF_TURN/PI)*atanf(((float)acc_y)/((float)acc_x)));	// computes the angle and converts it in heading units
+
+	// corrects the angle value according to the orientation of the accelerometer (see axis printed on the body)
+
+	// dial 1
+	if(acc_x > 0 && acc_y > 0){
+		angle = -angle - HEADING_HALF_TURN/2;
+	}
+
+	// dial 2
+	if(acc_x < 0 && acc_y > 0){
+		angle = -angle + HEADING_HALF_TURN/2;
+	}
+
+	// dial 3
+	if(acc_x < 0 && acc_y < 0){
+		angle = -angle + HEADING_HALF_TURN/2;
+	}
+
+	// dial 4
+	if(acc_x > 0 && acc_y <0){
+		angle = -angle - HEADING_HALF_TURN/2;
+	}
+
+	return angle;
+}
+
+/*
+ * difference between two headings, on the shortest side of the turn
+ *
+ * \return	a - b, in [-180 deg, +180 deg] [heading]
+ */
+heading_t heading_diff(heading_t a, heading_t b) {
+	int32_t diff = (int32_t)a - b;
+
+	if(diff > HEADING_HALF_TURN) {
+		diff -= 2 * HEADING_HALF_TURN;
+	} else if(diff < -HEADING_HALF_TURN) {
+		diff += 2 * HEADING_HALF_TURN;
+	}
+	return diff;
+}
+
+/*
+ * computes the averaged slope angle of a new sample
+ * In a flat surface, it is undefined, in that there is an inclination threshold and it is put to 0
+ *
+ * \param e			estimation to update, started with ESTIMATE_INIT()
+ *
+ * \param acc		accelerations of one sample, offsets removed
+ *
+ * \return			averaged slope angle [heading]
+ */
+heading_t estimate_update(estimate_t* e, const int16_t* acc) {
+	heading_t angle = 0; // computed angle (value to regulate)
+
+	e->inclination = average(acc[Z_AXIS], &e->sum_slope, e->values_slope, &e->counter_slope, e->slope_size); // averaging of the value
+
+	if(e->inclination > INCL_LIMIT) {
+		e->flat = false; // slope is sufficient to start regulation
+		angle = slope_angle(acc[X_AXIS], acc[Y_AXIS]); // computes the angle in the robot frame
+	} else {
+		angle = 0;
+		e->flat = true; // slope isn't sufficient to start regulation
+	}
+
+	e->angle = average(angle, &e->sum_angle, e->values_angle, &e->counter_angle, e->angle_size); // averaging of the angle
+
+	return e->angle;
+}
@@ -0,0 +1,61 @@
+/*
+ * estimate.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef ESTIMATE_H_
+#define ESTIMATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// heading : angle in fixed point, with HEADING_SCALE units in one degree
+// the convention of slope_angle() is kept, [-180 deg, +180 deg] fits in 16 bits
+typedef int16_t heading_t;
+#define HEADING_SCALE 100 // [0.01 deg]
+#define HEADING_HALF_TURN (180 * HEADING_SCALE)
+
+// customizable parameters
+
+#define INCL_LIMIT 300 // inclination threshold, if the slope isn't sufficient, the angle is 0
+
+#define AVERAGE_ANGLE_TIME 50 // time covered by the angle average at the fast period [ms]
+#define AVERAGE_SLOPE_TIME 50 // time covered by the slope average at the fast period [ms]
+
+// end of customizable parameters
+
+#define AVERAGE_SIZE(time, period) (((time) + (period) / 2) / (period)) // values of an average covering a time, rounded
+#define AVERAGE_SIZE_MAX 16 // biggest average of the estimation
+
+// the sizes chosen for estimate_t (ESTIMATE_INIT) must fit in its arrays : checked at compilation where they are defined
+#define AVERAGE_SIZE_CHECK(size) _Static_assert((size) >= 1 && (size) <= AVERAGE_SIZE_MAX, "average bigger than AVERAGE_SIZE_MAX")
+
+// real fast period of the angle computation [ms] (angle.c, batch.c) : the thread reading the IMU runs at its period,
+// the one waiting for the samples of the IMU (topic) computes on whole samples (5 ms gives 4 ms)
+#define ANGLE_PERIOD_REAL(period, imu_period, topic) (!(topic) ? (period) \
+		: ((period) < (imu_period)) ? (imu_period) : (period) / (imu_period) * (imu_period))
+
+// estimation of the slope : moving averages of the inclination and of the angle
+typedef struct {
+	int16_t angle_size;					// values of the angle average, at most AVERAGE_SIZE_MAX
+	int16_t slope_size;					// values of the slope average, at most AVERAGE_SIZE_MAX
+	int32_t sum_angle;
+	int16_t values_angle[AVERAGE_SIZE_MAX];
+	int16_t counter_angle;
+	int32_t sum_slope;
+	int16_t values_slope[AVERAGE_SIZE_MAX];
+	int16_t counter_slope;
+	heading_t angle;					// averaged slope angle [heading]
+	int16_t inclination;				// averaged acceleration on the Z axis (offset removed)
+	bool flat;							// true if the slope is small (the angle is 0)
+} estimate_t;
+
+#define ESTIMATE_INIT(angle_values, slope_values) {.angle_size = (angle_values), .slope_size = (slope_values), .flat = true}
+
+heading_t heading_diff(heading_t a, heading_t b);
+heading_t slope_angle(int16_t acc_x, int16_t acc_y);
+heading_t estimate_update(estimate_t* e, const int16_t* acc);
+
+#endif /* ESTIMATE_H_ */
@@ -0,0 +1,150 @@
+/*
+ * executive.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <angle.h>
+#include <prox.h>
+#include <regulation.h>
+#include <executive.h>
+#include <timebase.h>
+#include <chprintf.h>
+
+/*
+ * Cyclic executive (CYCLIC_EXECUTIVE true)
+ * The three periodic threads (angle 1024 B, proximity 1024 B and regulation 1024 B of stack) are replaced by
+ * one thread with a stack of 1024 B, the tasks run one after the other : 2048 B of stack and two thread
+ * descriptors are saved
+ * Each minor frame runs the tasks in a fixed order : sense (angle) -> detect (proximity) -> control (regulation)
+ * The jitter of both versions is given by get_release_stats()
+ */
+
+#define MINOR_FRAME 5 // period of the cyclic executive [ms], same as COMPUTE_ANGLE_PERIOD
+#define DETECT_FRAMES 10 // the proximity task runs every 10 frames (PROXIMITY_PERIOD)
+#define CONTROL_FRAMES 2 // the regulation task runs every 2 frames (REGUL_PERIOD)
+
+static release_stats_t releases[NB_TASKS] = {{0}}; // timing of the releases of each task
+static uint64_t last_release[NB_TASKS] = {0}; // time of the last release of each task [us]
+
+static bool control = false; // true when the regulation is added to the tasks
+
+/*
+ * measures the jitter of a periodic task, to call at the beginning of each release
+ *
+ * \param task		number of the task (TASK_ANGLE, TASK_PROX, TASK_REGUL, TASK_FRAME, TASK_RATE)
+ *
+ * \param period	expected time since the last release [ms]
+ */
+void release_update(uint8_t task, uint16_t period) {
+	uint64_t now = timebase_us();
+	uint32_t measured = now - last_release[task];
+	uint32_t jitter = (measured > period * 1000u) ? measured - period * 1000u : period * 1000u - measured;
+
+	chSysLock();
+	if(last_release[task] != 0) {
+		releases[task].releases++;
+		releases[task].jitter_sum += jitter;
+		if(jitter > releases[task].jitter_max) {
+			releases[task].jitter_max = (jitter < UINT16_MAX) ? jitter : UINT16_MAX;
+		}
+	}
+	last_release[task] = now;
+	chSysUnlock();
+}
+
+/*
+ * gives the timing of the releases of a task
+ *
+ * \param task		number of the task
+ *
+ * \param release	structure to fill
+ */
+void get_release_stats(uint8_t task, release_stats_t* release) {
+	chSysLock();
+	*release = releases[task];
+	chSysUnlock();
+}
+
+/*
+ * sends the jitter of the releases of each task, to compare the threads and the cyclic executive (CYCLIC_EXECUTIVE)
+ * the angle task changes its period (ADAPTIVE_PERIOD) : its jitter is measured against the period chosen
+ *
+ * \param out		stream to write to
+ */
+void release_print(BaseSequentialStream* out) {
+	static const char* names[NB_TASKS] = {"angle", "proximity", "regulation", "frame", "rate"};
+	release_stats_t r;
+
+	chprintf(out, "\r\nrelease jitter (%s) :\r\n", CYCLIC_EXECUTIVE ? "cyclic executive" : "threads");
+	chprintf(out, "%-12s %10s %10s %10s\r\n", "task", "releases", "mean [us]", "max [us]");
+	for(uint8_t i = 0 ; i < NB_TASKS ; i++) {
+		get_release_stats(i, &r);
+		if(r.releases == 0) {
+			continue; // not run in this configuration (frame, rate)
+		}
+		chprintf(out, "%-12s %10u %10u %10u\r\n", names[i], r.releases, r.jitter_sum / r.releases, r.jitter_max);
+	}
+}
+
+/*
+ * thread of the cyclic executive
+ * the angle task chooses its own period (multiple of MINOR_FRAME)
+ */
+static THD_WORKING_AREA(executive_thd_wa, 1024);
+static THD_FUNCTION(executive_thd, arg){
+
+	chRegSetThreadName(__FUNCTION__);
+	(void) arg;
+
+	systime_t time = chVTGetSystemTime();
+	uint32_t frame = 0; // number of the minor frame
+	uint16_t angle_frames = 0; // frames left before the next angle computation
+
+	while(1){
+		release_update(TASK_FRAME, MINOR_FRAME);
+
+		// sense
+		if(angle_frames == 0) {
+			angle_frames = angle_task() / MINOR_FRAME;
+		}
+		angle_frames--;
+
+		// detect
+		if(frame % DETECT_FRAMES == 0) {
+			prox_task();
+		}
+
+		// control
+		if(control && (frame % CONTROL_FRAMES == 0)) {
+			regulator_task();
+		}
+		if(control && CASCADE) { // inner loop of the cascaded control, every frame (RATE_PERIOD)
+			rate_task();
+		}
+
+		frame++;
+		chThdSleepUntilWindowed(time, time + MS2ST(MINOR_FRAME));
+		time += MS2ST(MINOR_FRAME);
+	}
+}
+
+/*
+ * starts the cyclic executive with the angle and proximity tasks
+ * the sensors must be calibrated before
+ */
+void executive_start(void) {
+	chThdCreateStatic(executive_thd_wa, sizeof(executive_thd_wa), NORMALPRIO + 1, executive_thd, NULL);
+}
+
+/*
+ * adds the regulation to the tasks of the cyclic executive
+ */
+void executive_start_control(void) {
+	control = true;
+}
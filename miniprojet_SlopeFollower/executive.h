@@ -0,0 +1,36 @@
+/*
+ * executive.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef EXECUTIVE_H_
+#define EXECUTIVE_H_
+
+#include <hal.h>
+
+#define CYCLIC_EXECUTIVE false // true to run the angle, proximity and regulation tasks in one thread instead of three
+
+// periodic tasks of the robot
+#define TASK_ANGLE 0
+#define TASK_PROX 1
+#define TASK_REGUL 2
+#define TASK_FRAME 3 // minor frame of the cyclic executive
+#define TASK_RATE 4 // inner loop of the cascaded control
+#define NB_TASKS 5
+
+// timing of the releases of a task
+typedef struct {
+	uint32_t releases;		// number of releases measured
+	uint16_t jitter_max;	// biggest difference between the measured and the expected period [us]
+	uint32_t jitter_sum;	// sum of the differences, jitter_sum / releases is the mean jitter [us]
+} release_stats_t;
+
+void release_update(uint8_t task, uint16_t period);
+void get_release_stats(uint8_t task, release_stats_t* release);
+void release_print(BaseSequentialStream* out);
+void executive_start(void);
+void executive_start_control(void);
+
+#endif /* EXECUTIVE_H_ */
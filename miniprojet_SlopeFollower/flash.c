@@ -0,0 +1,90 @@
+/*
+ * flash.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <flash.h>
+
+/*
+ * Internal flash, used to keep data between two boots (calibration.c, blackbox.c)
+ * The flash must be unlocked for the operations. While an operation runs, the reads of the flash wait :
+ * all the code stops, interrupts included (about 16 us per word, 1 to 2 s per sector erase)
+ * The ART accelerator keeps a data cache of the flash (constants, but also the sectors read by calibration.c
+ * and blackbox.c) : it isn't updated by the operations and must be reset before the data are read back
+ */
+
+/*
+ * empties the data cache of the ART accelerator, to call after each operation
+ * the cache can only be reset while it is disabled
+ */
+static void flash_cache_reset(void) {
+	FLASH->ACR &= ~FLASH_ACR_DCEN;
+	FLASH->ACR |= FLASH_ACR_DCRST;
+	FLASH->ACR &= ~FLASH_ACR_DCRST;
+	FLASH->ACR |= FLASH_ACR_DCEN;
+}
+
+/*
+ * waits for the end of a flash operation
+ *
+ * \return		true if the operation succeeded
+ */
+static bool flash_wait(void) {
+	while(FLASH->SR & FLASH_SR_BSY) {
+	}
+	if(FLASH->SR & (FLASH_SR_PGSERR | FLASH_SR_PGPERR | FLASH_SR_PGAERR | FLASH_SR_WRPERR | FLASH_SR_OPERR)) {
+		FLASH->SR = FLASH_SR_PGSERR | FLASH_SR_PGPERR | FLASH_SR_PGAERR | FLASH_SR_WRPERR | FLASH_SR_OPERR;
+		return false;
+	}
+	return true;
+}
+
+void flash_unlock(void) {
+	if(FLASH->CR & FLASH_CR_LOCK) {
+		FLASH->KEYR = 0x45670123;
+		FLASH->KEYR = 0xCDEF89AB;
+	}
+}
+
+void flash_lock(void) {
+	FLASH->CR |= FLASH_CR_LOCK;
+}
+
+/*
+ * programs one word (32 bit parallelism, 2.7 to 3.6 V)
+ */
+bool flash_program(volatile uint32_t* address, uint32_t value) {
+	bool ok = false;
+
+	FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_PG;
+	*address = value;
+	ok = flash_wait();
+	FLASH->CR &= ~FLASH_CR_PG;
+	flash_cache_reset();
+	return ok;
+}
+
+/*
+ * erases a sector, all its words become FLASH_ERASED
+ * blocks the flash (about 1 s) : only while the motors are stopped
+ *
+ * \param sector	number of the sector
+ *
+ * \return			true if the erase succeeded
+ */
+bool flash_erase(uint8_t sector) {
+	bool ok = false;
+
+	FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_SER | (sector << 3);
+	FLASH->CR |= FLASH_CR_STRT;
+	ok = flash_wait();
+	FLASH->CR &= ~FLASH_CR_SER;
+	flash_cache_reset();
+	return ok;
+}
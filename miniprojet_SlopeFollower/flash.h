@@ -0,0 +1,21 @@
+/*
+ * flash.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef FLASH_H_
+#define FLASH_H_
+
+#include <hal.h>
+
+#define FLASH_SECTOR_SIZE 0x20000 // sectors 5 to 11 of the STM32F407 [byte]
+#define FLASH_ERASED 0xFFFFFFFF // value of an erased word
+
+void flash_unlock(void);
+void flash_lock(void);
+bool flash_program(volatile uint32_t* address, uint32_t value);
+bool flash_erase(uint8_t sector);
+
+#endif /* FLASH_H_ */
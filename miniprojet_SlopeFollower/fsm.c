@@ -0,0 +1,202 @@
+/*
+ * fsm.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fsm.h>
+
+/*
+ * Table-driven hierarchical state machine
+ * The transition of a state for an event is found in the table [state][event], if the state doesn't handle
+ * the event its parent is tried : a step costs at most nb_events * FSM_MAX_DEPTH lookups and one transition.
+ * The time is given by the caller and nothing depends on ChibiOS : the machine can be driven on the host
+ * with scripted events.
+ */
+
+/*
+ * nesting level of a state, 0 for FSM_TOP
+ */
+static uint8_t depth(const fsm_t* fsm, uint8_t state) {
+	uint8_t level = 0;
+
+	while(state != FSM_TOP && level < FSM_MAX_DEPTH) {
+		state = fsm->states[state].parent;
+		level++;
+	}
+	return level;
+}
+
+/*
+ * enters a state from its ancestor : entry actions from the outermost to the innermost state
+ *
+ * \param from		ancestor already active
+ *
+ * \param to		state to enter
+ */
+static void enter(const fsm_t* fsm, uint8_t from, uint8_t to) {
+	uint8_t path[FSM_MAX_DEPTH] = {0}; // states to enter, from the innermost
+	uint8_t n = 0;
+
+	for(uint8_t s = to ; s != from && n < FSM_MAX_DEPTH ; s = fsm->states[s].parent) {
+		path[n++] = s;
+	}
+	while(n > 0) {
+		n--;
+		if(fsm->states[path[n]].entry != NULL) {
+			fsm->states[path[n]].entry();
+		}
+	}
+}
+
+/*
+ * takes a transition : exit actions up to the common ancestor of the current state and the target,
+ * action of the transition, then entry actions down to the target
+ * a transition to the current state exits and enters it again
+ */
+static void transit(fsm_t* fsm, uint8_t event, const fsm_transition_t* tr, uint32_t now) {
+	uint8_t a = fsm->current;
+	uint8_t b = tr->target;
+	uint8_t da = depth(fsm, a);
+	uint8_t db = depth(fsm, b);
+	fsm_log_t* entry = &fsm->log[fsm->transitions % FSM_LOG_SIZE];
+
+	// common ancestor
+	if(a == b) {
+		a = fsm->states[a].parent;
+	} else {
+		for( ; da > db ; da--) {
+			a = fsm->states[a].parent;
+		}
+		for( ; db > da ; db--) {
+			b = fsm->states[b].parent;
+		}
+		while(a != b) {
+			a = fsm->states[a].parent;
+			b = fsm->states[b].parent;
+		}
+	}
+
+	for(uint8_t s = fsm->current ; s != a ; s = fsm->states[s].parent) {
+		if(fsm->states[s].exit != NULL) {
+			fsm->states[s].exit();
+		}
+	}
+	if(tr->action != NULL) {
+		tr->action();
+	}
+	enter(fsm, a, tr->target);
+
+	entry->time = now;
+	entry->from = fsm->current;
+	entry->to = tr->target;
+	entry->event = event;
+	fsm->transitions++;
+
+	fsm->current = tr->target;
+	fsm->entered = now;
+}
+
+/*
+ * starts a state machine, the entry actions of the initial state are called
+ *
+ * \param states		states, states[FSM_TOP] encloses all the others
+ *
+ * \param table			transitions, nb_states rows of nb_events
+ *
+ * \param nb_events		number of events, FSM_TIMEOUT included (32 at most)
+ *
+ * \param initial		innermost state to start in
+ *
+ * \param now			time [ms]
+ */
+void fsm_init(fsm_t* fsm, const fsm_state_t* states, uint8_t nb_states, const fsm_transition_t* table,
+		uint8_t nb_events, uint8_t initial, uint32_t now) {
+	fsm->states = states;
+	fsm->table = table;
+	fsm->nb_states = nb_states;
+	fsm->nb_events = nb_events;
+	fsm->current = initial;
+	fsm->entered = now;
+	fsm->transitions = 0;
+
+	enter(fsm, FSM_TOP, initial);
+}
+
+/*
+ * one step of the state machine : takes at most one transition, then calls the run action
+ * the events are handled by number : the lowest raised event with a transition (guard true) is taken
+ * FSM_TIMEOUT is raised when the current state has been active for its timeout
+ *
+ * \param events		FSM_EVENT() of the events raised since the last step
+ *
+ * \param now			time [ms]
+ *
+ * \return				current state, after the transition
+ */
+uint8_t fsm_step(fsm_t* fsm, uint32_t events, uint32_t now) {
+	const fsm_transition_t* tr = NULL;
+	bool taken = false;
+
+	if(fsm->states[fsm->current].timeout != 0 && now - fsm->entered >= fsm->states[fsm->current].timeout) {
+		events |= FSM_EVENT(FSM_TIMEOUT);
+	}
+
+	for(uint8_t event = 0 ; event < fsm->nb_events && !taken ; event++) {
+		if(!(events & FSM_EVENT(event))) {
+			continue;
+		}
+		// the innermost state handling the event
+		for(uint8_t s = fsm->current ; s != FSM_TOP ; s = fsm->states[s].parent) {
+			tr = &fsm->table[s * fsm->nb_events + event];
+			if(tr->target != FSM_NOT_HANDLED && (tr->guard == NULL || tr->guard())) {
+				transit(fsm, event, tr, now);
+				taken = true;
+				break;
+			}
+		}
+	}
+
+	for(uint8_t s = fsm->current ; s != FSM_TOP ; s = fsm->states[s].parent) {
+		if(fsm->states[s].run != NULL) {
+			fsm->states[s].run();
+			break;
+		}
+	}
+
+	return fsm->current;
+}
+
+/*
+ * \return		true if the state is active (the current state or one of its parents)
+ */
+bool fsm_in(const fsm_t* fsm, uint8_t state) {
+	for(uint8_t s = fsm->current ; s != FSM_TOP ; s = fsm->states[s].parent) {
+		if(s == state) {
+			return true;
+		}
+	}
+	return state == FSM_TOP;
+}
+
+/*
+ * gives a transition of the log
+ *
+ * \param index		0 for the oldest transition kept
+ *
+ * \param entry		structure to fill
+ *
+ * \return			false if there is no transition at this index
+ */
+bool fsm_get_log(const fsm_t* fsm, uint8_t index, fsm_log_t* entry) {
+	uint32_t kept = (fsm->transitions < FSM_LOG_SIZE) ? fsm->transitions : FSM_LOG_SIZE;
+
+	if(index >= kept) {
+		return false;
+	}
+	*entry = fsm->log[(fsm->transitions - kept + index) % FSM_LOG_SIZE];
+	return true;
+}
@@ -0,0 +1,66 @@
+/*
+ * fsm.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef FSM_H_
+#define FSM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FSM_TOP 0 // state enclosing all the others, never the target of a transition
+#define FSM_NOT_HANDLED FSM_TOP // target of the events a state doesn't handle (given to its parent)
+#define FSM_TIMEOUT 0 // event raised when the current state has been active for its timeout, first priority
+#define FSM_EVENT(event) ((uint32_t)1 << (event)) // event raised, to combine with |
+#define FSM_MAX_DEPTH 4 // nesting levels of the states, FSM_TOP included
+#define FSM_LOG_SIZE 16 // last transitions kept
+
+typedef bool (*fsm_guard_t)(void);
+typedef void (*fsm_action_t)(void);
+
+// state, the actions are NULL if not needed
+typedef struct {
+	const char* name;
+	uint8_t parent;			// enclosing state (FSM_TOP for the outermost ones)
+	fsm_action_t entry;		// when the state becomes active
+	fsm_action_t exit;		// when the state stops being active
+	fsm_action_t run;		// at each step while the state is active, the innermost run of the active states is called
+	uint16_t timeout;		// time in the state after which FSM_TIMEOUT is raised [ms], 0 for none
+} fsm_state_t;
+
+// transition of the table [state][event]
+typedef struct {
+	uint8_t target;			// state to go to, FSM_NOT_HANDLED if the state doesn't handle the event
+	fsm_guard_t guard;		// the transition is taken only if it returns true, NULL for always
+	fsm_action_t action;	// between the exit and the entry actions
+} fsm_transition_t;
+
+// transition taken
+typedef struct {
+	uint32_t time;			// [ms]
+	uint8_t from;
+	uint8_t to;
+	uint8_t event;
+} fsm_log_t;
+
+typedef struct {
+	const fsm_state_t* states;
+	const fsm_transition_t* table;	// nb_states rows of nb_events transitions
+	uint8_t nb_states;
+	uint8_t nb_events;
+	uint8_t current;				// innermost active state
+	uint32_t entered;				// time of the entry in the current state [ms]
+	uint32_t transitions;			// number of transitions since the start
+	fsm_log_t log[FSM_LOG_SIZE];	// circular, log[transitions % FSM_LOG_SIZE] is the next one
+} fsm_t;
+
+void fsm_init(fsm_t* fsm, const fsm_state_t* states, uint8_t nb_states, const fsm_transition_t* table,
+		uint8_t nb_events, uint8_t initial, uint32_t now);
+uint8_t fsm_step(fsm_t* fsm, uint32_t events, uint32_t now);
+bool fsm_in(const fsm_t* fsm, uint8_t state);
+bool fsm_get_log(const fsm_t* fsm, uint8_t index, fsm_log_t* entry);
+
+#endif /* FSM_H_ */
@@ -21,6 +21,21 @@
 #include <i2c_bus.h>
 #include <angle.h>
 #include <leds.h>
+#include <bench.h>
+#include <executive.h>
+#include <odometry.h>
+#include <calibration.h>
+#include <button.h>
+#include <sensors/proximity.h>
+#include <boot.h>
+#include <trace.h>
+#include <blackbox.h>
+#include <timebase.h>
+#include <map.h>
+
+#define SENSORS_START_TIME 100 // time for the first measurements of the sensors [ms]
+
+#define BENCHMARK false // true to run the benchmark of the hot functions instead of the normal operations (see bench.c)
 
 // inits the message bus, the mutexe and the conditionnal variable used for the communication with the IMU and the proximity sensors
 // It is necessary to include main.h in the files where the bus is used
@@ -41,23 +56,6 @@ static void serial_start(void)
 	sdStart(&SD3, &ser_cfg); // UART3.
 }
 
-// inits the timer 12
-static void timer12_start(void){
-    // General Purpose Timer configuration
-    // timer 12 is a 16 bit timer so we can measure time
-    // to about 65ms with a 1Mhz counter
-    static const GPTConfig gpt12cfg = {
-        1000000,        /* 1MHz timer clock in order to measure uS.*/
-        NULL,           /* Timer callback.*/
-        0,
-        0
-    };
-
-    gptStart(&GPTD12, &gpt12cfg);
-    // let the timer count to max value
-    gptStartContinuous(&GPTD12, 0xFFFF);
-}
-
 /*
  * function controlling the LEDs
  * Two red LEDs turn on when the calibration starts
@@ -73,6 +71,94 @@ void leds_calibration(unsigned int state) {
     }
 }
 
+static bool calibrate = false; // true if the sensors are calibrated during this boot
+
+/*
+ * boot phases, see boot_phases[] for their dependencies
+ */
+
+// starts the sensors, uses the stored calibration unless the user holds the button to calibrate again
+static void boot_sensors(void) {
+    imu_start(); // starts the IMU
+    proximity_start(); // starts the proximity sensors
+    chThdSleepMilliseconds(SENSORS_START_TIME); // first measurements, the IMU temperature is needed to check the calibration
+
+    calibrate = button_is_pressed() || !calibration_load();
+}
+
+// before a calibration, to allow the user to remove their hands
+static void boot_user(void) {
+	if(calibrate) {
+		chThdSleepMilliseconds(2000);
+		leds_calibration(1); // red LEDs turn on
+	}
+}
+
+// calibrates the IMU if needed and starts the thread dedicated to the computation of the angle
+// the gyroscope offset is measured at each boot, not stored (it drifts with the temperature) : used by the black box and CASCADE
+static void boot_imu(void) {
+	calibrate_gyro();
+	compute_angle_thd_start(calibrate);
+}
+
+// calibrates the proximity sensors if needed and starts the thread dedicated to the proximity sensors
+static void boot_ir(void) {
+	prox_sensors_start(calibrate);
+}
+
+// the angle and proximity tasks run in the cyclic executive instead of their threads
+static void boot_executive(void) {
+    if(CYCLIC_EXECUTIVE) {
+    	executive_start();
+    }
+}
+
+// waits for the first results of the tasks, whether they run in their threads or in the cyclic executive :
+// averages of the angle filled and first sample of the proximity sensors
+static void boot_ready(void) {
+	angle_wait_ready();
+	prox_wait_ready();
+}
+
+// stores the calibration for the next boots and opens the black box, before the motors start (the flash is blocked during the erase)
+static void boot_save(void) {
+	if(calibrate) {
+		calibration_save();
+	}
+	if(BLACKBOX) {
+		blackbox_start();
+	}
+}
+
+// end of calibrations, starts the thread dedicated to the regulation and motors control
+static void boot_regulator(void) {
+    leds_calibration(0); // red LEDs turn off & bodyLEDs turn on
+    regulator_start();
+}
+
+#define BOOT_SENSORS 0
+#define BOOT_USER 1
+#define BOOT_IMU 2
+#define BOOT_IR 3
+#define BOOT_EXECUTIVE 4
+#define BOOT_READY 5
+#define BOOT_SAVE 6
+#define BOOT_REGULATOR 7
+#define NB_BOOT_PHASES 8
+
+// the IMU and the proximity sensors are calibrated at the same time
+// the robot should stay on a flat surface and far from the walls during a calibration
+static boot_phase_t boot_phases[NB_BOOT_PHASES] = {
+	{"sensors",		boot_sensors,	0},
+	{"user",		boot_user,		BOOT_DEP(BOOT_SENSORS)},
+	{"imu",			boot_imu,		BOOT_DEP(BOOT_USER)},
+	{"ir",			boot_ir,		BOOT_DEP(BOOT_USER)},
+	{"executive",	boot_executive,	BOOT_DEP(BOOT_IMU) | BOOT_DEP(BOOT_IR)},
+	{"ready",		boot_ready,		BOOT_DEP(BOOT_EXECUTIVE)},
+	{"save",		boot_save,		BOOT_DEP(BOOT_IMU) | BOOT_DEP(BOOT_IR)},
+	{"regulator",	boot_regulator,	BOOT_DEP(BOOT_READY) | BOOT_DEP(BOOT_SAVE)},
+};
+
 /*
  * main function
  * does only initializations
@@ -87,26 +173,45 @@ int main(void)
     chSysInit();
 
     serial_start(); // starts the serial communication
-    timer12_start(); // starts timer 12
-
-    chThdSleepMilliseconds(2000); // sleep before calibration, to allow the user to remove their hands
-
-    leds_calibration(1); // red LEDs turn on
-
-    // sensors calibration and threads start
-    // the robot should stay on a flat surface and far from the walls
-    compute_angle_thd_start(); // calibrates the IMU and starts the thread dedicated to the computation of the angle
-    prox_sensors_start(); // calibrates the proximity sensors and starts the thread dedicated to the proximity sensors
-
-    chThdSleepMilliseconds(1000); // sleep between calibration and motors start
-
-    // end of calibrations
-    leds_calibration(0); // red LEDs turn off & bodyLEDs turn on
+    timebase_start(); // starts timer 12, time of the measurements and the logs
+
+    if(BENCHMARK) {
+    	// the robot doesn't move, the results are sent on the serial port
+    	if(benchmark_run()) {
+    		set_body_led(1); // no regression, or measurement only without stored baseline
+    	} else {
+    		set_led(LED1, 1); // at least one regression or case without baseline
+    	}
+    	while (1) {
+    		chThdSleepMilliseconds(1000);
+    	}
+    }
 
-    regulator_start(); // starts the thread dedicated to the regulation and motors control
+    boot_run(boot_phases, NB_BOOT_PHASES); // sensors calibration and threads start
+    boot_print((BaseSequentialStream *)&SD3, boot_phases, NB_BOOT_PHASES); // where the boot time goes
 
     /* Infinite loop. */
+    bool printed = false; // true when the performance of the run has been sent
+    odometry_stats_t run;
+    uint16_t seconds = 0; // time since the end of the boot [s]
     while (1) {
+    	// scheduler trace, to draw the timeline with tools/trace_timeline.py
+    	seconds++;
+    	if(TRACE_DUMP && seconds % TRACE_DUMP_PERIOD == 0) {
+    		trace_dump((BaseSequentialStream *)&SD3);
+    	}
+
+    	// sends the performance on the serial port once the run is over
+    	get_odometry_stats(&run);
+    	if(run.ended && !printed) {
+    		odometry_print((BaseSequentialStream *)&SD3);
+    		motion_print((BaseSequentialStream *)&SD3); // what the robot did, for the diagnostics
+    		angle_print((BaseSequentialStream *)&SD3); // wake-ups saved by the slow period, samples of the IMU duplicated or dropped
+    		release_print((BaseSequentialStream *)&SD3); // jitter of the tasks, threads or cyclic executive
+    		map_print((BaseSequentialStream *)&SD3); // obstacles kept in the map
+    		trace_stacks((BaseSequentialStream *)&SD3); // margin of the stacks after a whole run
+    		printed = true;
+    	}
     	chThdSleepMilliseconds(1000); //sleep so that the main doesn't take resources
     }
 }
@@ -0,0 +1,300 @@
+/*
+ * map.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <ch.h>
+#include <hal.h>
+#include <chprintf.h>
+#include <prox.h>
+#include <odometry.h>
+#include <map.h>
+
+/*
+ * Map of the slope around the path of the robot, to go around the obstacles already met
+ * The frame is the one of the odometry : x along the fall line (descent), y across it (lateral drift, to the left
+ * looking downhill). The heading comes from the slope itself (get_angle()), only the position drifts.
+ * Each cell keeps the evidence of an obstacle (proximity alerts, at the bearing and range estimated by prox.c)
+ * and the mean inclination measured in it.
+ * The cells are in a fixed table of MAP_SETS sets of MAP_WAYS cells : a cell can only be in the set given by its
+ * coordinates, a new cell replaces the least recently used one of its set, the obstacles last.
+ * The route is the direction closest to the descent whose corridor is free of obstacles over MAP_LOOKAHEAD,
+ * given to the regulation as the angle to reach.
+ */
+
+#define MAP_CELL 60 // side of a cell [mm], about the diameter of the robot
+#define MAP_SETS 32 // power of 2
+#define MAP_WAYS 4 // cells of a set : 128 cells, 1.5 kB
+#define MAP_HIT 4 // evidence added at each period with a proximity alert
+#define MAP_FREE 4 // evidence removed each time the robot enters the cell
+#define MAP_OBSTACLE 8 // evidence from which a cell is an obstacle (2 periods with an alert)
+#define MAP_EVIDENCE_MAX 64
+#define MAP_INCL_FILTER 0.1f // weight of a new inclination in the mean of a cell
+
+#define MAP_ROUTE_PERIOD 10 // the route is chosen every MAP_ROUTE_PERIOD calls of map_update()
+#define MAP_LOOKAHEAD 300 // length of the route checked in the map [mm]
+#define MAP_CLEARANCE 40 // half width of the corridor checked [mm], robot radius
+#define MAP_ROUTE_STEP 15 // angle between two routes tried [deg]
+#define MAP_ROUTE_MAX 60 // largest deviation from the descent [deg]
+
+#define PI 3.14159f
+#define DEG_TO_RAD (PI / 180)
+
+typedef struct {
+	int8_t x;				// coordinates [MAP_CELL]
+	int8_t y;
+	bool used;
+	uint8_t evidence;		// of an obstacle, obstacle from MAP_OBSTACLE
+	int16_t inclination;	// mean inclination measured in the cell (the gradient is along x)
+	uint32_t last;			// call of map_update() of the last write, for the eviction
+} map_cell_t;
+
+static map_cell_t cells[MAP_SETS][MAP_WAYS] = {0};
+static map_stats_t stats = {0};
+static uint32_t calls = 0; // calls of map_update(), clock of the eviction
+
+/*
+ * \return		coordinate of the cell of a position [MAP_CELL]
+ */
+static int8_t to_cell(float mm) {
+	float c = floorf(mm / MAP_CELL);
+
+	if(c > INT8_MAX) {
+		return INT8_MAX;
+	} else if(c < -INT8_MAX) {
+		return -INT8_MAX;
+	}
+	return c;
+}
+
+/*
+ * set of a cell : the 8 neighbors of a cell are in other sets
+ */
+static map_cell_t* set_of(int8_t x, int8_t y) {
+	return cells[(uint32_t)(x * 5 + y) & (MAP_SETS - 1)];
+}
+
+/*
+ * \return		cell at these coordinates, NULL if it isn't in the map
+ */
+static map_cell_t* find(int8_t x, int8_t y) {
+	map_cell_t* set = set_of(x, y);
+
+	for(uint8_t w = 0 ; w < MAP_WAYS ; w++) {
+		if(set[w].used && set[w].x == x && set[w].y == y) {
+			return &set[w];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * cell at these coordinates, added to the map if needed
+ * replaces a free cell, else the least recently used cell without obstacle, else the least recently used one
+ */
+static map_cell_t* write(int8_t x, int8_t y) {
+	map_cell_t* set = set_of(x, y);
+	map_cell_t* cell = find(x, y);
+	map_cell_t* victim = NULL;
+	map_cell_t* oldest = &set[0];
+
+	if(cell != NULL) {
+		cell->last = calls;
+		return cell;
+	}
+
+	for(uint8_t w = 0 ; w < MAP_WAYS ; w++) {
+		if(!set[w].used) {
+			victim = &set[w];
+			break;
+		}
+		if(set[w].evidence < MAP_OBSTACLE && (victim == NULL || set[w].last < victim->last)) {
+			victim = &set[w];
+		}
+		if(set[w].last < oldest->last) {
+			oldest = &set[w];
+		}
+	}
+	if(victim == NULL) {
+		victim = oldest;
+	}
+	if(victim->used) {
+		stats.evictions++;
+		if(victim->evidence >= MAP_OBSTACLE) {
+			stats.obstacles_lost++;
+		}
+	}
+
+	victim->x = x;
+	victim->y = y;
+	victim->used = true;
+	victim->evidence = 0;
+	victim->inclination = get_inclination();
+	victim->last = calls;
+	return victim;
+}
+
+/*
+ * \param dir		direction of the route in the frame of the map [rad]
+ *
+ * \return			true if an obstacle of the map is in the corridor of the route
+ */
+static bool blocked(float x, float y, float dir) {
+	float c = cosf(dir);
+	float s = sinf(dir);
+	const map_cell_t* cell = NULL;
+
+	for(int16_t d = MAP_CELL / 2 ; d <= MAP_LOOKAHEAD ; d += MAP_CELL / 2) {
+		for(int8_t side = -1 ; side <= 1 ; side++) {
+			cell = find(to_cell(x + d * c - side * MAP_CLEARANCE * s), to_cell(y + d * s + side * MAP_CLEARANCE * c));
+			if(cell != NULL && cell->evidence >= MAP_OBSTACLE) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/*
+ * route closest to the descent, the current one is kept while the descent is blocked
+ * deviations on the side of the current route are tried first
+ *
+ * \return		angle to reach [heading], 0 if every route is blocked (the escape maneuvers do the job)
+ */
+static heading_t choose_route(float x, float y) {
+	int8_t side = (stats.route < 0) ? -1 : 1;
+
+	if(!blocked(x, y, 0)) {
+		return 0;
+	}
+	if(stats.route != 0 && !blocked(x, y, stats.route * DEG_TO_RAD / HEADING_SCALE)) {
+		return stats.route;
+	}
+	for(int8_t deviation = MAP_ROUTE_STEP ; deviation <= MAP_ROUTE_MAX ; deviation += MAP_ROUTE_STEP) {
+		if(!blocked(x, y, side * deviation * DEG_TO_RAD)) {
+			return side * deviation * HEADING_SCALE;
+		}
+		if(!blocked(x, y, -side * deviation * DEG_TO_RAD)) {
+			return -side * deviation * HEADING_SCALE;
+		}
+	}
+	return 0;
+}
+
+/*
+ * writes the position of the robot and its proximity alert in the map, to call at each regulation period
+ * after odometry_update()
+ * the route is chosen every MAP_ROUTE_PERIOD, out of the escape maneuvers
+ *
+ * \param escaping		true if an escape maneuver is running
+ */
+void map_update(bool escaping) {
+	static int8_t x_last = 0; // cell of the robot at the last call
+	static int8_t y_last = 0;
+	static bool on_slope = false;
+
+	odometry_stats_t run;
+	prox_obstacle_t obstacle;
+	int8_t alert = get_prox_alert();
+	float heading = get_angle() * DEG_TO_RAD / HEADING_SCALE; // direction of the robot in the map
+	float bearing = 0;
+	int8_t x = 0;
+	int8_t y = 0;
+	map_cell_t* cell = NULL;
+	heading_t route = 0;
+
+	calls++;
+	get_odometry_stats(&run);
+	if(get_slope() || run.ended) { // no heading on a small slope
+		on_slope = false;
+		return;
+	}
+
+	// cell of the robot : it is free each time the robot enters it
+	x = to_cell(run.descent);
+	y = to_cell(run.lateral);
+	cell = write(x, y);
+	cell->inclination += MAP_INCL_FILTER * (get_inclination() - cell->inclination);
+	if(!on_slope || x != x_last || y != y_last) {
+		cell->evidence = (cell->evidence > MAP_FREE) ? cell->evidence - MAP_FREE : 0;
+	}
+	x_last = x;
+	y_last = y;
+	on_slope = true;
+
+	// obstacle of the alert, where the sensors see it
+	get_prox_obstacle(&obstacle);
+	if(alert != 0 && obstacle.range != PROX_RANGE_NONE) {
+		bearing = heading + obstacle.bearing * DEG_TO_RAD / HEADING_SCALE;
+		cell = write(to_cell(run.descent + obstacle.range * cosf(bearing)), to_cell(run.lateral + obstacle.range * sinf(bearing)));
+		cell->evidence = (cell->evidence + MAP_HIT < MAP_EVIDENCE_MAX) ? cell->evidence + MAP_HIT : MAP_EVIDENCE_MAX;
+		stats.detections++;
+	}
+
+	if(!escaping && calls % MAP_ROUTE_PERIOD == 0) {
+		route = choose_route(run.descent, run.lateral);
+		chSysLock();
+		if(route != stats.route) {
+			stats.reroutes++;
+		}
+		stats.route = route;
+		chSysUnlock();
+	}
+}
+
+/*
+ * allows to get the route around the obstacles in an other file
+ *
+ * \return		angle to reach between the slope and the front of the robot [heading]
+ */
+heading_t map_route(void) {
+	return stats.route;
+}
+
+/*
+ * gives the use of the map
+ *
+ * \param use		structure to fill
+ */
+void get_map_stats(map_stats_t* use) {
+	chSysLock();
+	*use = stats;
+	chSysUnlock();
+
+	use->cells = 0;
+	use->obstacles = 0;
+	for(uint8_t s = 0 ; s < MAP_SETS ; s++) {
+		for(uint8_t w = 0 ; w < MAP_WAYS ; w++) {
+			use->cells += cells[s][w].used;
+			use->obstacles += cells[s][w].used && cells[s][w].evidence >= MAP_OBSTACLE;
+		}
+	}
+}
+
+/*
+ * sends the use of the map and its obstacles
+ *
+ * \param out		stream to write to
+ */
+void map_print(BaseSequentialStream* out) {
+	map_stats_t use;
+
+	get_map_stats(&use);
+
+	chprintf(out, "\r\nmap : %u cells of %u, %u obstacles\r\n", use.cells, MAP_SETS * MAP_WAYS, use.obstacles);
+	chprintf(out, "detections %u, evictions %u (%u obstacles), reroutes %u\r\n", use.detections, use.evictions,
+			use.obstacles_lost, use.reroutes);
+	for(uint8_t s = 0 ; s < MAP_SETS ; s++) {
+		for(uint8_t w = 0 ; w < MAP_WAYS ; w++) {
+			if(cells[s][w].used && cells[s][w].evidence >= MAP_OBSTACLE) {
+				chprintf(out, "obstacle at %5d mm %5d mm, evidence %u, inclination %d\r\n", cells[s][w].x * MAP_CELL,
+						cells[s][w].y * MAP_CELL, cells[s][w].evidence, cells[s][w].inclination);
+			}
+		}
+	}
+}
@@ -0,0 +1,30 @@
+/*
+ * map.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef MAP_H_
+#define MAP_H_
+
+#include <hal.h>
+#include <angle.h>
+
+// use of the map since the start
+typedef struct {
+	uint16_t cells;			// cells in use
+	uint16_t obstacles;		// cells marked as obstacles
+	uint32_t detections;	// proximity alerts written in the map
+	uint32_t evictions;		// cells replaced by a new one
+	uint32_t obstacles_lost;	// obstacle cells replaced (the map was too small)
+	uint32_t reroutes;		// changes of the route around the obstacles
+	heading_t route;		// current angle to reach given by the map [heading]
+} map_stats_t;
+
+void map_update(bool escaping);
+heading_t map_route(void);
+void get_map_stats(map_stats_t* use);
+void map_print(BaseSequentialStream* out);
+
+#endif /* MAP_H_ */
@@ -0,0 +1,124 @@
+/*
+ * odometry.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <ch.h>
+#include <hal.h>
+#include <chprintf.h>
+#include <motors.h>
+#include <angle.h>
+#include <odometry.h>
+
+/*
+ * Descent performance of the robot
+ * The distance given by the steps of both wheels is projected on the slope direction given by get_angle() :
+ * along the fall line it is the descent, across it is the lateral drift
+ */
+
+#define PI 3.14159
+
+#define STEP_TO_MM 0.13 // distance travelled by a wheel for one step [mm] (wheel perimeter 130 mm, 1000 steps per turn)
+
+#define RUN_END_TIME 2000 // time on a flat surface after a descent to end the run [ms]
+
+static odometry_stats_t stats = {0}; // performance of the current run
+
+/*
+ * integrates the movement of the wheels since the last call, to call at each regulation period
+ * the run begins on the first slope and ends when the robot stays on a flat surface after it
+ *
+ * \param escaping		true if an escape maneuver is running
+ *
+ * \param period		time since the last call [ms]
+ */
+void odometry_update(bool escaping, uint16_t period) {
+	static int32_t left_last = 0; // wheel positions at the last call [step]
+	static int32_t right_last = 0;
+	static bool escaping_last = false;
+	static uint16_t flat_time = 0; // time on a flat surface since the last slope [ms]
+
+	int32_t left = left_motor_get_pos();
+	int32_t right = right_motor_get_pos();
+	float distance = (left - left_last + right - right_last) / 2.f * STEP_TO_MM; // distance travelled by the center of the robot
+	float angle = get_angle() * PI / HEADING_HALF_TURN; // slope direction in the robot frame
+
+	left_last = left;
+	right_last = right;
+
+	if(stats.ended) {
+		return;
+	}
+
+	// time on a flat surface, before or after the slope
+	if(get_slope()) {
+		if(stats.time != 0) {
+			flat_time += period;
+			if(flat_time >= RUN_END_TIME) {
+				stats.ended = true;
+			}
+		}
+		escaping_last = escaping;
+		return;
+	}
+	flat_time = 0;
+
+	chSysLock();
+	stats.time += period;
+	stats.descent += distance * cosf(angle);
+	stats.lateral += distance * sinf(angle);
+	stats.travelled += fabsf(distance);
+	if(escaping) {
+		stats.escape_time += period;
+		if(!escaping_last) {
+			stats.escapes++;
+		}
+	}
+	chSysUnlock();
+
+	escaping_last = escaping;
+}
+
+/*
+ * gives the performance of the current run
+ *
+ * \param run		structure to fill
+ */
+void get_odometry_stats(odometry_stats_t* run) {
+	chSysLock();
+	*run = stats;
+	chSysUnlock();
+}
+
+/*
+ * sends the performance of the current run
+ * descent throughput : descent per second on the slope
+ * path efficiency : descent divided by the distance travelled
+ *
+ * \param out		stream to write to (serial port)
+ */
+void odometry_print(BaseSequentialStream* out) {
+	odometry_stats_t run;
+
+	get_odometry_stats(&run);
+
+	chprintf(out, "\r\nrun : %s\r\n", run.ended ? "ended" : "running");
+	chprintf(out, "time on the slope    %u ms\r\n", run.time);
+	chprintf(out, "descent              %.1f mm\r\n", run.descent);
+	chprintf(out, "lateral drift        %.1f mm\r\n", run.lateral);
+	if(run.time != 0) {
+		chprintf(out, "descent throughput   %.1f mm/s\r\n", run.descent * 1000 / run.time);
+	}
+	if(run.travelled != 0) {
+		chprintf(out, "path efficiency      %.2f\r\n", run.descent / run.travelled);
+	}
+	chprintf(out, "escapes              %u\r\n", run.escapes);
+	if(run.escapes != 0) {
+		chprintf(out, "time lost per escape %u ms\r\n", run.escape_time / run.escapes);
+	}
+}
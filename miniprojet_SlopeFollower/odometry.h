@@ -0,0 +1,28 @@
+/*
+ * odometry.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef ODOMETRY_H_
+#define ODOMETRY_H_
+
+#include <hal.h>
+
+// performance of a run, accumulated while the robot is on the slope
+typedef struct {
+	float descent;			// distance descended along the fall line [mm]
+	float lateral;			// drift across the fall line, positive to the left when looking downhill [mm]
+	float travelled;		// distance travelled by the wheels [mm]
+	uint32_t time;			// time on the slope [ms]
+	uint16_t escapes;		// number of escape maneuvers
+	uint32_t escape_time;	// time spent in escape maneuvers [ms]
+	bool ended;				// true when the robot is back on a flat surface after a descent
+} odometry_stats_t;
+
+void odometry_update(bool escaping, uint16_t period);
+void get_odometry_stats(odometry_stats_t* run);
+void odometry_print(BaseSequentialStream* out);
+
+#endif /* ODOMETRY_H_ */
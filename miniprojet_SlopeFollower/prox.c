@@ -7,18 +7,44 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
+#include <hal.h>
 #include <prox.h>
 #include <msgbus/messagebus.h>
 #include <sensors/proximity.h>
 #include <stdbool.h>
 #include <leds.h>
+#include <executive.h>
+#include <chprintf.h>
+#include <calibration.h>
 
 // Proximity threshold : above this proximity value, a proximity alert is enabled
 #define PROXIMITY_TRESHOLD 600
+// Exit threshold : the alert stays enabled until the proximity of its sensor goes under this value
+#define PROXIMITY_TRESHOLD_EXIT 450
 
-// measured time to execute thread content : 3 us
+#define PROX_FILTER true // true to filter the sensors and confirm the alerts, false to react to a single sample
+#define FILTER_WEIGHT 0.5f // weight of the new sample in the filtered value of a sensor (1 : no filter)
+#define CONFIRM_SAMPLES 2 // number of consecutive samples with the same alert to enable it
+
+#define PROX_LOG false // true to send the raw sensor values on the serial port at each period (to record IR logs)
+
+// time to execute thread content : measured by the benchmark (see bench.c)
 #define PROXIMITY_PERIOD 50 // period of the proximity thread (in ms)
 
+// Repulsive steering : speed difference given by each sensor for one unit of proximity [step/s]
+// an obstacle on the right makes the robot turn left (negative speed difference)
+#define STEER_FRONT 0.35f	// IR1 and IR8, close to the direction of movement
+#define STEER_CENTER 0.25f	// IR2 and IR7
+#define STEER_SIDE 0.1f		// IR3 and IR6, the obstacle is already beside the robot
+#define STEER_NOISE 100		// proximity under which a sensor doesn't steer
+#define STEER_MAX 500		// limit of the steering speed difference [step/s]
+
+// Obstacle estimate : the proximity decreases exponentially with the distance of the obstacle
+#define PROX_CONTACT 3800.f	// proximity of an obstacle touching a sensor
+#define PROX_DECAY 9.f		// distance for which the proximity is divided by e [mm]
+#define PROX_RADIUS 35		// distance of the sensors from the center of the robot [mm]
+
 // Sensors numbers definition
 #define RIGHT_3 2		// IR3 on the body
 #define RIGHT_2 1		// IR2 on the body
@@ -27,9 +53,22 @@
 #define LEFT_2 6		// IR7 on the body
 #define LEFT_3 5		// IR6 on the body
 
+// geometry of the sensors, in the order of the alerts (R_SIDE to L_SIDE) : direction counterclockwise from the front [deg]
+static const float sensor_bearing[NB_PROX_SENSORS] = {-90, -49, -17, 17, 49, 90};
+
+#define PI 3.14159f
+#define DEG_TO_RAD (PI / 180)
+
 extern messagebus_t bus; // communication variable defined in main.c
 
 static int8_t proximity_alert = 0; // Proximity alert variable
+static int16_t proximity_max = 0; // highest value of the 6 sensors
+static int16_t proximity_steering = 0; // speed difference to turn away from the obstacles
+static uint8_t confidence = 0; // consecutive samples with the same alert candidate
+static int16_t filtered[L_SIDE] = {0}; // filtered value of each sensor, at the number of its alert - 1
+static prox_obstacle_t obstacle = {0, PROX_RANGE_NONE}; // obstacle estimated with all the sensors
+static bool started = false; // true after the first sample : the filters start from it
+static BSEMAPHORE_DECL(ready, true); // taken until the first sample (prox_wait_ready())
 
 /*
  * allows to  get the value of the proximity alert in an other file
@@ -41,15 +80,207 @@ int8_t get_prox_alert(void){
 }
 
 /*
- * thread dedicated to the acquisition of the proximity with the 6 sensors at the front of the robot (IR 1, 2, 3, 6, 7, 8)
+ * allows to get the highest proximity value in an other file
+ *
+ * \return highest calibrated value of the 6 sensors
  */
-static THD_WORKING_AREA(get_proximity_thd_wa, 1024);
-static THD_FUNCTION(get_proximity_thd, arg){
+int16_t get_prox_max(void){
+	return proximity_max;
+}
 
-	chRegSetThreadName(__FUNCTION__);
-	(void) arg;
+/*
+ * allows to get the steering away from the obstacles in an other file
+ *
+ * \return speed difference to add to the regulator output [step/s]
+ */
+int16_t get_prox_steering(void){
+	return proximity_steering;
+}
 
-	systime_t time;
+/*
+ * allows to get the confidence in the current alert candidate in an other file
+ *
+ * \return confidence [%], 100 when the alert is confirmed
+ */
+uint8_t get_prox_confidence(void){
+	return (confidence >= CONFIRM_SAMPLES) ? 100 : confidence * 100 / CONFIRM_SAMPLES;
+}
+
+/*
+ * allows to get the obstacle estimated with all the sensors in an other file
+ *
+ * \param estimate		structure to fill
+ */
+void get_prox_obstacle(prox_obstacle_t* estimate){
+	chSysLock();
+	*estimate = obstacle;
+	chSysUnlock();
+}
+
+/*
+ * first order filter of a sensor, against the noise and the ambient light
+ * the first sample is taken as it is, the filter doesn't start from 0
+ *
+ * \param value		new sample
+ *
+ * \param alert		number of the alert given by this sensor
+ *
+ * \return			filtered value
+ */
+static int16_t filter(int16_t value, int8_t alert) {
+	if(PROX_FILTER && started) {
+		filtered[alert - 1] += FILTER_WEIGHT * (value - filtered[alert - 1]);
+	} else {
+		filtered[alert - 1] = value;
+	}
+	return filtered[alert - 1];
+}
+
+/*
+ * hysteresis and confirmation of the alert
+ * a new alert needs CONFIRM_SAMPLES consecutive candidates, then it is kept
+ * until its sensor goes under PROXIMITY_TRESHOLD_EXIT
+ *
+ * \param candidate		alert given by the logical structure on the filtered values
+ *
+ * \return				alert to give to the regulator
+ */
+static int8_t confirm_alert(int8_t candidate) {
+	static int8_t last_candidate = 0;
+
+	if(!PROX_FILTER) {
+		confidence = (candidate != 0) ? CONFIRM_SAMPLES : 0;
+		return candidate;
+	}
+
+	// an enabled alert stays until its sensor is far enough
+	if(proximity_alert != 0 && filtered[proximity_alert - 1] > PROXIMITY_TRESHOLD_EXIT) {
+		return proximity_alert;
+	}
+	// then it moves to the sensor of the candidate without confirmation : it is the same obstacle
+	// (the alert would be 0 for CONFIRM_SAMPLES - 1 periods at each change of sensor along a wall)
+	if(proximity_alert != 0 && candidate != 0) {
+		last_candidate = candidate;
+		return candidate;
+	}
+
+	if(candidate == 0) {
+		confidence = 0;
+	} else if(candidate == last_candidate) {
+		if(confidence < CONFIRM_SAMPLES) {
+			confidence++;
+		}
+	} else {
+		confidence = 1;
+	}
+	last_candidate = candidate;
+
+	return (confidence >= CONFIRM_SAMPLES) ? candidate : 0;
+}
+
+/*
+ * calibrated value of a sensor, with the stored ambient value
+ *
+ * \param sensor	number of the sensor
+ *
+ * \return			proximity value
+ */
+static int16_t read_prox(uint8_t sensor) {
+	return get_prox(sensor) - get_ir_calibration(sensor);
+}
+
+/*
+ * repulsion of one sensor
+ *
+ * \param value		proximity value of the sensor
+ *
+ * \param weight	steering for one unit of proximity, signed with the side of the sensor
+ *
+ * \return			speed difference given by this sensor [step/s]
+ */
+static float steering(int16_t value, float weight) {
+	if(value < STEER_NOISE) {
+		return 0;
+	}
+	return (value - STEER_NOISE) * weight;
+}
+
+/*
+ * logical structure to determine the number of alert from the 6 proximity values
+ * the sensor above the threshold which is the closest to an obstacle gives the alert
+ *
+ * \return number of the proximity alert (0 if no alert)
+ */
+int8_t compute_prox_alert(int16_t proxy_right_3, int16_t proxy_right_2, int16_t proxy_right_1,
+						  int16_t proxy_left_1, int16_t proxy_left_2, int16_t proxy_left_3) {
+
+	// alert on the right_3 :
+	if (proxy_right_3 > PROXIMITY_TRESHOLD && proxy_right_3 > proxy_right_2){
+		return R_SIDE;
+	}
+	// alert on the right_2 :
+	else if (proxy_right_2 > PROXIMITY_TRESHOLD && proxy_right_2 > proxy_right_3 && proxy_right_2 > proxy_right_1){
+		return R_CENTER;
+	}
+	// alert on the right_1 :
+	else if (proxy_right_1 > PROXIMITY_TRESHOLD && proxy_right_1 > proxy_right_2 && proxy_right_1 > proxy_left_1){
+		return R_FRONT;
+	}
+	// alert on the left_1 :
+	else if (proxy_left_1 > PROXIMITY_TRESHOLD && proxy_left_1 > proxy_left_2 && proxy_left_1 > proxy_right_1){
+		return L_FRONT;
+	}
+	// alert on the left_2 :
+	else if (proxy_left_2 > PROXIMITY_TRESHOLD && proxy_left_2 > proxy_left_1 && proxy_left_2 > proxy_left_3){
+		return L_CENTER;
+	}
+	// alert on the left_3 :
+	else if(proxy_left_3 > PROXIMITY_TRESHOLD && proxy_left_3 > proxy_left_2){
+		return L_SIDE;
+	}
+
+	return 0;
+}
+
+/*
+ * continuous estimate of the obstacle with all the sensors, instead of the sensor of the alert
+ * bearing : centroid of the directions of the sensors, weighted by their proximity above STEER_NOISE
+ * range : from the highest proximity, with the exponential decrease of the proximity with the distance
+ *
+ * \param proximity		values of the sensors, in the order of the alerts (R_SIDE to L_SIDE)
+ *
+ * \param obstacle			structure to fill, range PROX_RANGE_NONE if no sensor sees an obstacle
+ */
+void compute_prox_obstacle(const int16_t* proximity, prox_obstacle_t* obstacle) {
+	float x = 0; // centroid
+	float y = 0;
+	int16_t highest = STEER_NOISE;
+	float distance = 0; // from the sensor [mm]
+
+	for(uint8_t i = 0 ; i < NB_PROX_SENSORS ; i++) {
+		if(proximity[i] > STEER_NOISE) {
+			x += (proximity[i] - STEER_NOISE) * cosf(sensor_bearing[i] * DEG_TO_RAD);
+			y += (proximity[i] - STEER_NOISE) * sinf(sensor_bearing[i] * DEG_TO_RAD);
+			highest = (proximity[i] > highest) ? proximity[i] : highest;
+		}
+	}
+
+	if(highest == STEER_NOISE) {
+		obstacle->bearing = 0;
+		obstacle->range = PROX_RANGE_NONE;
+		return;
+	}
+
+	distance = PROX_DECAY * logf(PROX_CONTACT / highest);
+	obstacle->bearing = atan2f(y, x) / DEG_TO_RAD * HEADING_SCALE;
+	obstacle->range = PROX_RADIUS + ((distance > 0) ? distance : 0);
+}
+
+/*
+ * acquisition of the proximity with the 6 sensors at the front of the robot (IR 1, 2, 3, 6, 7, 8)
+ * called every PROXIMITY_PERIOD
+ */
+void prox_task(void) {
 
 	// Proximity variables
 	int16_t proxy_right_3 = 0;
@@ -58,59 +289,107 @@ static THD_FUNCTION(get_proximity_thd, arg){
 	int16_t proxy_left_1 = 0;
 	int16_t proxy_left_2 = 0;
 	int16_t proxy_left_3 = 0;
+	float steer = 0; // steering away from the obstacles
+	prox_obstacle_t estimate;
 
-	while(1){
+	release_update(TASK_PROX, PROXIMITY_PERIOD);
 
-		time = chVTGetSystemTime();
+	// get the sensor values
+	proxy_right_3 = read_prox(RIGHT_3);
+	proxy_right_2 = read_prox(RIGHT_2);
+	proxy_right_1 = read_prox(RIGHT_1);
+	proxy_left_1 = read_prox(LEFT_1);
+	proxy_left_2 = read_prox(LEFT_2);
+	proxy_left_3 = read_prox(LEFT_3);
 
-		// get the sensor values
-		proxy_right_3 = get_calibrated_prox(RIGHT_3);
-		proxy_right_2 = get_calibrated_prox(RIGHT_2);
-		proxy_right_1 = get_calibrated_prox(RIGHT_1);
-		proxy_left_1 = get_calibrated_prox(LEFT_1);
-		proxy_left_2 = get_calibrated_prox(LEFT_2);
-		proxy_left_3 = get_calibrated_prox(LEFT_3);
+	if(PROX_LOG) {
+		chprintf((BaseSequentialStream *)&SD3, "%d %d %d %d %d %d\r\n",
+				proxy_right_3, proxy_right_2, proxy_right_1, proxy_left_1, proxy_left_2, proxy_left_3);
+	}
 
-		// logical structure to determine the number of alert
+	// filtered values
+	proxy_right_3 = filter(proxy_right_3, R_SIDE);
+	proxy_right_2 = filter(proxy_right_2, R_CENTER);
+	proxy_right_1 = filter(proxy_right_1, R_FRONT);
+	proxy_left_1 = filter(proxy_left_1, L_FRONT);
+	proxy_left_2 = filter(proxy_left_2, L_CENTER);
+	proxy_left_3 = filter(proxy_left_3, L_SIDE);
 
-		// alert on the right_3 :
-		if (proxy_right_3 > PROXIMITY_TRESHOLD && proxy_right_3 > proxy_right_2){
-			proximity_alert = R_SIDE;
-		}
-		// alert on the right_2 :
-		else if (proxy_right_2 > PROXIMITY_TRESHOLD && proxy_right_2 > proxy_right_3 && proxy_right_2 > proxy_right_1){
-			proximity_alert = R_CENTER;
-		}
-		// alert on the right_1 :
-		else if (proxy_right_1 > PROXIMITY_TRESHOLD && proxy_right_1 > proxy_right_2 && proxy_right_1 > proxy_left_1){
-			proximity_alert = R_FRONT;
-		}
-		// alert on the left_1 :
-		else if (proxy_left_1 > PROXIMITY_TRESHOLD && proxy_left_1 > proxy_left_2 && proxy_left_1 > proxy_right_1){
-			proximity_alert = L_FRONT;
-		}
-		// alert on the left_2 :
-		else if (proxy_left_2 > PROXIMITY_TRESHOLD && proxy_left_2 > proxy_left_1 && proxy_left_2 > proxy_left_3){
-			proximity_alert = L_CENTER;
-		}
-		// alert on the left_3 :
-		else if(proxy_left_3 > PROXIMITY_TRESHOLD && proxy_left_3 > proxy_left_2){
-			proximity_alert = L_SIDE;
-		}
-		else{
-			proximity_alert = 0;
-		}
+	// determines the number of alert
+	proximity_alert = confirm_alert(compute_prox_alert(proxy_right_3, proxy_right_2, proxy_right_1, proxy_left_1, proxy_left_2, proxy_left_3));
+
+	// bearing and range of the obstacle
+	compute_prox_obstacle(filtered, &estimate);
+	chSysLock();
+	obstacle = estimate;
+	chSysUnlock();
+
+	// repulsion of all the sensors, to turn away from the obstacles while moving
+	steer = steering(proxy_left_1, STEER_FRONT) + steering(proxy_left_2, STEER_CENTER) + steering(proxy_left_3, STEER_SIDE)
+		  - steering(proxy_right_1, STEER_FRONT) - steering(proxy_right_2, STEER_CENTER) - steering(proxy_right_3, STEER_SIDE);
+	if(steer > STEER_MAX) {
+		steer = STEER_MAX;
+	} else if(steer < -STEER_MAX) {
+		steer = -STEER_MAX;
+	}
+	proximity_steering = steer;
+
+	// closest obstacle, to slow down before the alert
+	proximity_max = proxy_right_3;
+	proximity_max = (proxy_right_2 > proximity_max) ? proxy_right_2 : proximity_max;
+	proximity_max = (proxy_right_1 > proximity_max) ? proxy_right_1 : proximity_max;
+	proximity_max = (proxy_left_1 > proximity_max) ? proxy_left_1 : proximity_max;
+	proximity_max = (proxy_left_2 > proximity_max) ? proxy_left_2 : proximity_max;
+	proximity_max = (proxy_left_3 > proximity_max) ? proxy_left_3 : proximity_max;
+
+	if(!started) {
+		started = true;
+		chBSemSignal(&ready);
+	}
+}
+
+/*
+ * waits until the first sample of the proximity sensors is processed (thread or cyclic executive)
+ * to call once, after prox_sensors_start()
+ */
+void prox_wait_ready(void) {
+	chBSemWait(&ready);
+}
+
+/*
+ * thread dedicated to the acquisition of the proximity
+ */
+static THD_WORKING_AREA(get_proximity_thd_wa, 1024);
+static THD_FUNCTION(get_proximity_thd, arg){
+
+	chRegSetThreadName(__FUNCTION__);
+	(void) arg;
+
+	systime_t time;
+
+	while(1){
+
+		time = chVTGetSystemTime();
+
+		prox_task();
 
 		chThdSleepUntilWindowed(time, time + MS2ST(PROXIMITY_PERIOD));
 	}
 }
 
 /*
- * Initializes and calibrates the proximity sensors, starts the thread dedicated to the alert of proximity
+ * Calibrates the proximity sensors if needed, starts the thread dedicated to the alert of proximity
+ * the proximity sensors must be started
+ *
+ * \param calibrate		true to calibrate, false to use the stored calibration
  */
-void prox_sensors_start(void) {
-	proximity_start();
-	calibrate_ir();
-	chThdSleepMilliseconds(1500);
-	chThdCreateStatic(get_proximity_thd_wa, sizeof(get_proximity_thd_wa), NORMALPRIO, get_proximity_thd, NULL);
+void prox_sensors_start(bool calibrate) {
+	if(calibrate) {
+		calibrate_ir();
+		calibration_store_ir(); // keeps the ambient values for the next boots
+		chThdSleepMilliseconds(1500);
+	}
+	if(!CYCLIC_EXECUTIVE) { // with the cyclic executive, the acquisition is one of its tasks
+		chThdCreateStatic(get_proximity_thd_wa, sizeof(get_proximity_thd_wa), NORMALPRIO, get_proximity_thd, NULL);
+	}
 }
@@ -8,6 +8,8 @@
 #ifndef PROX_H_
 #define PROX_H_
 
+#include <angle.h>
+
 // proximity alerts definition
 #define R_SIDE 1
 #define R_CENTER 2
@@ -16,8 +18,26 @@
 #define L_CENTER 5
 #define L_SIDE 6
 
+#define NB_PROX_SENSORS 6 // sensors at the front of the robot, one per alert
+#define PROX_RANGE_NONE INT16_MAX // range when no obstacle is seen
+
+// obstacle estimated with all the sensors
+typedef struct {
+	heading_t bearing;	// direction of the obstacle, counterclockwise from the front [heading]
+	int16_t range;		// distance of the obstacle from the center of the robot [mm], PROX_RANGE_NONE if none
+} prox_obstacle_t;
+
 int get_proximity(int sensor_number);
 int8_t get_prox_alert(void);
-void prox_sensors_start(void);
+int16_t get_prox_max(void);
+int16_t get_prox_steering(void);
+uint8_t get_prox_confidence(void);
+void get_prox_obstacle(prox_obstacle_t* obstacle);
+void prox_task(void);
+int8_t compute_prox_alert(int16_t proxy_right_3, int16_t proxy_right_2, int16_t proxy_right_1,
+						  int16_t proxy_left_1, int16_t proxy_left_2, int16_t proxy_left_3);
+void compute_prox_obstacle(const int16_t* proximity, prox_obstacle_t* obstacle);
+void prox_sensors_start(bool calibrate);
+void prox_wait_ready(void);
 
 #endif /* PROX_H_ */
@@ -7,31 +7,63 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <motors.h>
 #include <regulation.h>
 #include <angle.h>
 #include <prox.h>
 #include <leds.h>
 #include <average.h>
+#include <executive.h>
+#include <drive.h>
+#include <odometry.h>
+#include <chprintf.h>
+#include <sensors/imu.h>
+#include <fsm.h>
+#include <timebase.h>
+#include <map.h>
 
 // customizable parameters
 
-#define ANGLE_COMMAND 0 // angle to reach between the slope and the front of the robot
+#define ANGLE_COMMAND 0 // angle to reach between the slope and the front of the robot [deg]
 
-#define ARW true // true to activate the Anti Reset Windup
+#define MAP_ROUTING true // true to go around the obstacles already met (map.c), the route is added to ANGLE_COMMAND
 
-// regulator constants
-#define KP 5
-#define KI 0.02
+#define STEER_AVOIDANCE true // true to turn away from the obstacles while moving, escape maneuvers only for front obstacles
+#define STEER_PATIENCE 600 // STEER_AVOIDANCE : an alert longer than this time needs an escape maneuver, whatever its sensor [ms]
+
+#define ESCAPE_SIZED true // true to turn just enough to clear the obstacle (bearing and range of prox.c), false for the PERCENT_* of the alert
+
+#define REGUL_LOG false // true to send the heading and the speed difference on the serial port at each period (to fit the yaw model with tools/sysid.py)
+
+// the constants of the regulator and of the cruise speed are in control.h (shared with the batch simulation)
+
+// cascaded control (CASCADE)
+#define RATE_PERIOD 5 // period of the inner loop [ms], the IMU gives a gyroscope sample every 4 ms (MINOR_FRAME of the cyclic executive)
+#define KP_HEADING 4 // outer loop : yaw rate to reach for a heading error of one degree [deg/s]
+#define YAW_RATE_MAX 150 // yaw rate limit of the outer loop [deg/s]
+#define KP_RATE 2 // inner loop constants, for a yaw rate error of one deg/s [step/s]
+#define KI_RATE 0.1 // 0.5 makes the inner loop oscillate (about 2 Hz, 20 deg)
 
 // end of customizable parameters
 
-// operating modes
-#define NORMAL false	// standard
-#define ESCAPING true	// proximity alert : escape maneuver
+// movement states (motion_states)
+#define ST_TOP FSM_TOP
+#define ST_DRIVE 1		// the regulation drives the robot
+#define ST_SLOPE 2		// in drive : follows the descent
+#define ST_FLAT 3		// in drive : small slope, goes straight
+#define ST_ESCAPE 4		// proximity alert : escape maneuver
+#define NB_MOTION_STATES 5
+
+// events of the movement states, by priority
+#define EV_TIMEOUT FSM_TIMEOUT
+#define EV_OBSTACLE 1	// proximity alert
+#define EV_FLAT 2		// small slope
+#define EV_SLOPE 3
+#define EV_PERIOD 4		// every period, for the transitions on a guard only
+#define NB_MOTION_EVENTS 5
 
-#define SPEED_MAX  1000 // wheels maximum speed [step/s]
-#define SPEED_MOY (SPEED_MAX/2) // wheel average speed during the normal operations
+#define ESCAPE_TIMEOUT 2000 // longest escape maneuver [ms], the robot drives again even if the rotation isn't done
 
 // percentage of turn to do during escape maneuvers
 #define PERCENT_FRONT 50
@@ -40,69 +72,171 @@
 
 #define STEPS_TURN 1320 // number of steps to do a 360 turn
 
-// measured time to execute thread content : 12 us
-// period of the regulation thread [ms]
-#define REGUL_PERIOD 10
+// escape maneuvers sized with the obstacle (ESCAPE_SIZED)
+#define ESCAPE_CLEARANCE 50 // distance between the obstacle and the path of the center of the robot after the rotation [mm] (radius 37 mm)
+#define ESCAPE_MARGIN 10 // rotation added to the one that clears the obstacle [deg], for the error of the estimate
 
-#define AVERAGE_SIZE_SPEED 10 // size of the moving average for the speed command
+#define HEADING_COMMAND (ANGLE_COMMAND * HEADING_SCALE) // angle to reach [heading]
+
+#define YAW_RATE_GAIN 0.281f // yaw rate of a speed difference, without slip [deg/s per step/s] : 2 * 0.13 mm / 53 mm in deg
+#define GYRO_AXIS 2 // Z axis of the gyroscope, pointing down : positive when the robot turns right
+#define RAD_TO_DEG 57.2958f
+
+static regul_t regul = REGUL_INIT; // state of the regulator
 
 /*
- * PI regulator
- * input : slope direction (angle) relative to the front of the robot
- * output : speed difference to apply to the motors
- * A variable speed diference signify controllable turns
+ * PI regulator of the robot (regulator_step() of control.c, PID with the derivative term when PID is true)
  *
- * \param mesured_angle		slope angle measured by the angle thread
+ * \param mesured_angle		slope angle measured by the angle thread [heading]
  *
- * \param angle_to_reach	angle to reach (always 0 here)
+ * \param angle_to_reach	angle to reach [heading]
  *
- * \param reset				if true : reset of the regulator variables
+ * \param mode				REGUL_RUN, REGUL_RESET (small slope : all the terms to 0)
+ * 							or REGUL_RESUME (first period after another mode : bumpless transfer)
  *
  * \return					speed difference to apply to the motors
  */
-int16_t regulator(int16_t mesured_angle, int16_t angle_to_reach, bool reset){
-	int16_t err = 0; // angle error
-	float prop = 0; // proportional term, float because order depends on the KP
-	float integr = 0; // integral term, float because order depends on the KI
-	static float integr_last = 0; // last value of the integral term
-	static int16_t delta_speed_ini = 0; // delta speed before limit check (to keep for the ARW)
-	static int16_t delta_speed = 0; // output to compute (to keep for the ARW)
+int16_t regulator(heading_t mesured_angle, heading_t angle_to_reach, uint8_t mode){
+	return regulator_step(&regul, mesured_angle, angle_to_reach, mode);
+}
 
-	err = mesured_angle - angle_to_reach;
+/*
+ * allows to get the terms of the last regulation in another file
+ *
+ * \param last		structure to fill
+ */
+void get_regulator_terms(regul_terms_t* last) {
+	*last = regul.terms; // read by another thread : the three terms may come from two periods
+}
 
-	prop = KP * (float)err;
-	if(KI != 0) { // useless if KI = 0
-		integr = integr_last + KI * (float)err;
-	}
+/*
+ * outer loop of the cascaded control (CASCADE)
+ * input : slope direction (angle) relative to the front of the robot
+ * output : yaw rate to reach, followed by the inner loop (rate_task)
+ * proportional only : the robot integrates the yaw rate into the heading, the inner loop corrects the slip
+ *
+ * \param err		heading error [heading]
+ *
+ * \return			yaw rate to reach, positive to the right [deg/s]
+ */
+float yaw_rate_command(heading_t err) {
+	float rate = KP_HEADING * (float)err / HEADING_SCALE;
 
-	// integral term to reset if needed (end of escape maneuver or small slope)
-	if(reset || err == 0) {
-		integr = 0;
-		integr_last = 0;
+	if(rate > YAW_RATE_MAX) {
+		rate = YAW_RATE_MAX;
+	} else if(rate < -YAW_RATE_MAX) {
+		rate = -YAW_RATE_MAX;
 	}
 
-	delta_speed_ini = prop + integr; // commands computation
+	return rate;
+}
 
-	// limits management
-	if (delta_speed_ini > SPEED_MAX) {
-		delta_speed = SPEED_MAX;
-	} else if (delta_speed_ini < -SPEED_MAX) {
-		delta_speed = -SPEED_MAX;
-	} else {
-		delta_speed = delta_speed_ini;
+// variables shared by the outer loop (regulator_task) and the inner loop (rate_task), protected by the system lock
+static float rate_to_reach = 0; // yaw rate given by the outer loop [deg/s]
+static int16_t rate_linear = 0; // cruise speed given by the outer loop [step/s]
+static bool rate_following = false; // true in normal mode : the inner loop gives the speed difference
+static bool rate_reset = false; // true to reset the integral term of the inner loop at its next period
+
+/*
+ * gives a new command to the inner loop
+ *
+ * \param rate			yaw rate to reach [deg/s]
+ *
+ * \param linear		cruise speed [step/s]
+ *
+ * \param following		false to let another command drive the motors (escape maneuver)
+ *
+ * \param reset			true to reset the integral term of the inner loop
+ */
+static void rate_set(float rate, int16_t linear, bool following, bool reset) {
+	chSysLock();
+	rate_to_reach = rate;
+	rate_linear = linear;
+	rate_following = following;
+	rate_reset = rate_reset || reset;
+	chSysUnlock();
+}
+
+/*
+ * inner loop of the cascaded control, called every RATE_PERIOD
+ * PI regulator on the yaw rate measured by the gyroscope, with the speed difference that gives the yaw rate
+ * without slip as feedforward : the PI only corrects the slip and the lag of the robot
+ * drives the motors : with CASCADE, the regulation task doesn't call drive_update()
+ */
+void rate_task(void) {
+	static float integr = 0; // integral term [step/s]
+	float rate = 0; // yaw rate to reach [deg/s]
+	float err = 0; // yaw rate error [deg/s]
+	float integr_new = 0;
+	float delta_speed = 0;
+	int16_t linear = 0;
+	bool following = false;
+	bool reset = false;
+
+	release_update(TASK_RATE, RATE_PERIOD);
+
+	chSysLock();
+	rate = rate_to_reach;
+	linear = rate_linear;
+	following = rate_following;
+	reset = rate_reset;
+	rate_reset = false;
+	chSysUnlock();
+
+	if(reset) {
+		integr = 0;
 	}
 
-	// ARW management, useless if KI = 0
-	if (KI != 0) {
-		// if ARW is activated AND there is saturation AND integration term would get bigger
-		if((ARW == true) && (delta_speed != delta_speed_ini) && abs(integr) >  abs(integr_last)) {
-			integr = integr_last; // integral term, can't get bigger
+	if(following) {
+		err = rate - get_gyro_rate(GYRO_AXIS) * RAD_TO_DEG;
+		integr_new = integr + KI_RATE * err;
+		delta_speed = rate / YAW_RATE_GAIN + KP_RATE * err + integr_new;
+
+		// limits management, the integral term only changes out of saturation (ARW)
+		if(delta_speed > SPEED_MAX) {
+			delta_speed = SPEED_MAX;
+		} else if(delta_speed < -SPEED_MAX) {
+			delta_speed = -SPEED_MAX;
 		} else {
-			integr_last = integr; // normally stocks integral term in the last one
+			integr = integr_new;
 		}
+
+		drive_set_command(linear, delta_speed);
+	}
+
+	drive_update(RATE_PERIOD); // both wheels follow the command with limited acceleration
+}
+
+/*
+ * cruise speed scheduling (speed_schedule() of control.c) with the inclination and the closest obstacle
+ *
+ * \param err				heading error [heading]
+ *
+ * \param delta_speed		speed difference that will be applied to the motors
+ *
+ * \return					cruise speed [step/s]
+ */
+int16_t cruise_speed(heading_t err, int16_t delta_speed) {
+	return speed_schedule(err, delta_speed, get_inclination(), get_prox_max());
+}
+
+/*
+ * smallest rotation after which the robot goes straight past the obstacle
+ * the path of the center clears the obstacle by ESCAPE_CLEARANCE when its bearing is above asin(clearance / range)
+ *
+ * \return		number of steps to do
+ */
+static int32_t escape_steps(const prox_obstacle_t* obstacle) {
+	float bearing = abs(obstacle->bearing) / (float)HEADING_SCALE; // [deg]
+	float clear = 90; // bearing that clears the obstacle [deg]
+	float rotation = 0;
+
+	if(obstacle->range > ESCAPE_CLEARANCE) {
+		clear = asinf((float)ESCAPE_CLEARANCE / obstacle->range) * RAD_TO_DEG;
 	}
+	rotation = ((clear > bearing) ? clear - bearing : 0) + ESCAPE_MARGIN;
 
-	return delta_speed;
+	return STEPS_TURN * rotation / 360;
 }
 
 /*
@@ -112,9 +246,11 @@ int16_t regulator(int16_t mesured_angle, int16_t angle_to_reach, bool reset){
  *
  * \param alert_number		Position of proximity alert
  *
+ * \param obstacle			bearing and range of the obstacle, used with ESCAPE_SIZED
+ *
  * \retun					number of steps to do to finish the escape maneuver
  */
-int32_t escape(int8_t alert_number) {
+int32_t escape(int8_t alert_number, const prox_obstacle_t* obstacle) {
 	int32_t steps_to_do = 0; // motors step to do to finish the escape maeuver
 	int16_t speed = 0; // motors speed
 
@@ -160,24 +296,245 @@ int32_t escape(int8_t alert_number) {
 		break;
 	}
 
-	// motor command
-	left_motor_set_speed(speed);
-	right_motor_set_speed(-speed);
-	left_motor_set_pos(0); // reset the positions counter (we only use one)
+	// the rotation away from the obstacle that is just enough, the side of the alert if it is straight ahead
+	if(ESCAPE_SIZED && obstacle->range != PROX_RANGE_NONE) {
+		steps_to_do = escape_steps(obstacle);
+		if(obstacle->bearing != 0) {
+			speed = (obstacle->bearing > 0) ? SPEED_MAX : -SPEED_MAX; // obstacle on the left : turns right
+		}
+	}
+
+	// motor command, the robot turns on itself
+	drive_set_command(0, speed);
 
 	return abs(steps_to_do);
 }
 
+// variables of the movement command, kept between two periods
+static fsm_t motion; // movement states
+static int8_t prox_alert = 0; // proximity alert of the current period
+static uint16_t alert_time = 0; // time since the proximity alert started, up to STEER_PATIENCE [ms]
+static int16_t steps_to_do = 0; // steps to do to finish an escape maneuver
+static int32_t escape_start = 0; // difference between the wheel positions at the beginning of the escape maneuver
+static bool resume = false; // true if the next regulation is a bumpless transfer (start or end of an escape maneuver)
+
+// variables used for the moving average of the speed difference
+static int32_t sum_dSpeed = 0;
+static int16_t values_dSpeed[AVERAGE_SIZE_SPEED] = {0};
+static int16_t counter_dSpeed = 0;
+
+/*
+ * actions and guards of the movement states
+ */
+
+// drive : the regulation gives the speed command
+static void drive_entry(void) {
+	resume = true;
+}
+
+/*
+ * regulation of the heading, at each period in the drive states
+ * calls the PI regulator, or gives the yaw rate to reach to the inner loop (CASCADE)
+ *
+ * \param flat		true on a small slope : the heading isn't defined
+ */
+static void drive_run(bool flat) {
+	heading_t command = HEADING_COMMAND + (MAP_ROUTING ? map_route() : 0); // angle to reach
+	heading_t err = heading_diff(get_angle(), command); // heading error with the last computed angle
+	int16_t delta_speed = 0; // speed difference between the motors
+	int16_t delta_speed_mean = 0; // averaged speed difference (to smooth the movement)
+	float rate = 0; // yaw rate to reach with the cascaded control [deg/s]
+
+	if(CASCADE) {
+		rate = yaw_rate_command(err);
+		if(STEER_AVOIDANCE) {
+			rate += get_prox_steering() * YAW_RATE_GAIN; // turns away from the obstacles
+		}
+		// the inner loop gives the speed difference : the last one limits the cruise speed, resets the inner loop after an escape
+		rate_set(rate, cruise_speed(err, resume ? 0 : drive_get_angular()), true, resume);
+	} else {
+		if(resume) {
+			delta_speed = regulator(get_angle(), command, REGUL_RESUME); // bumpless transfer from the escape maneuver
+			// the history of the average holds the commands before the escape maneuver : replaced by the new command
+			delta_speed_mean = average_fill(delta_speed, &sum_dSpeed, values_dSpeed, &counter_dSpeed, AVERAGE_SIZE_SPEED);
+		} else {
+			delta_speed = regulator(get_angle(), command, flat ? REGUL_RESET : REGUL_RUN); // PI regulator, reset on a small slope
+			delta_speed_mean = average(delta_speed, &sum_dSpeed, values_dSpeed, &counter_dSpeed, AVERAGE_SIZE_SPEED); // moving average of the command
+		}
+		if(STEER_AVOIDANCE) {
+			delta_speed_mean += get_prox_steering(); // turns away from the obstacles, not averaged to react quickly
+			if(delta_speed_mean > SPEED_MAX) {
+				delta_speed_mean = SPEED_MAX;
+			} else if(delta_speed_mean < -SPEED_MAX) {
+				delta_speed_mean = -SPEED_MAX;
+			}
+		}
+		// motors command with the regulated and averaged value
+		drive_set_command(cruise_speed(err, delta_speed_mean), delta_speed_mean);
+	}
+	resume = false;
+}
+
+static void slope_run(void) {
+	drive_run(false);
+}
+
+static void flat_run(void) {
+	drive_run(true);
+}
+
+// escape : the robot turns on itself, away from an obstacle
+// with the steering, only an obstacle in front of the robot needs an escape maneuver,
+// or on the slope an obstacle on the side that stays : the slope pushes the robot against it, the steering alone is stuck
+// (on a small slope, the robot goes straight and the steering takes it along the obstacle)
+static bool escape_needed(void) {
+	return !STEER_AVOIDANCE || prox_alert == R_FRONT || prox_alert == L_FRONT
+			|| (alert_time >= STEER_PATIENCE && fsm_in(&motion, ST_SLOPE));
+}
+
+static void escape_entry(void) {
+	prox_obstacle_t obstacle;
+
+	get_prox_obstacle(&obstacle);
+	alert_time = 0; // an alert still there after the escape maneuver waits again
+	if(CASCADE) {
+		rate_set(0, 0, false, false); // the inner loop leaves the motors to the escape maneuver
+	}
+	steps_to_do = escape(prox_alert, &obstacle); // start of the escape maneuver and storage of the step to do to finish it
+	escape_start = left_motor_get_pos() - right_motor_get_pos(); // the positions are kept for the odometry
+}
+
+// rotation only, the wheels may still be slowing down
+static bool escape_done(void) {
+	return abs(left_motor_get_pos() - right_motor_get_pos() - escape_start) / 2 >= steps_to_do;
+}
+
+static void escape_exit(void) {
+	clear_leds(); // turn the red LEDs off
+}
+
+static const fsm_state_t motion_states[NB_MOTION_STATES] = {
+	// name			parent		entry			exit			run			timeout [ms]
+	{"top",			ST_TOP,		NULL,			NULL,			NULL,		0},
+	{"drive",		ST_TOP,		drive_entry,	NULL,			NULL,		0},
+	{"slope",		ST_DRIVE,	NULL,			NULL,			slope_run,	0},
+	{"flat",		ST_DRIVE,	NULL,			NULL,			flat_run,	0},
+	{"escape",		ST_TOP,		escape_entry,	escape_exit,	NULL,		ESCAPE_TIMEOUT},
+};
+
+static const char* motion_events[NB_MOTION_EVENTS] = {"timeout", "obstacle", "flat", "slope", "period"};
+
+// transitions : target, guard, action
+// the events a state doesn't handle are given to its parent (obstacle for slope and flat)
+static const fsm_transition_t motion_table[NB_MOTION_STATES][NB_MOTION_EVENTS] = {
+	[ST_DRIVE] = {
+		[EV_OBSTACLE] =		{ST_ESCAPE,	escape_needed,	NULL},
+	},
+	[ST_SLOPE] = {
+		[EV_FLAT] =			{ST_FLAT,	NULL,			NULL},
+	},
+	[ST_FLAT] = {
+		[EV_SLOPE] =		{ST_SLOPE,	NULL,			NULL},
+	},
+	[ST_ESCAPE] = {
+		[EV_TIMEOUT] =		{ST_SLOPE,	NULL,			NULL},
+		[EV_PERIOD] =		{ST_SLOPE,	escape_done,	NULL},
+	},
+};
+
+/*
+ * movement command, called every REGUL_PERIOD
+ * raises the events of the period and steps the state machine of the movement (motion_table) :
+ * the regulation in the drive states, the escape maneuvers when a wall is close
+ * gives the speed command to the drive
+ */
+void regulator_task(void) {
+	uint32_t events = FSM_EVENT(EV_PERIOD);
+
+	release_update(TASK_REGUL, REGUL_PERIOD);
+
+	prox_alert = get_prox_alert(); // alerts returned by the proximity sensors
+	if(prox_alert == 0) {
+		alert_time = 0;
+	} else if(alert_time < STEER_PATIENCE) {
+		alert_time += REGUL_PERIOD;
+	}
+	if(prox_alert != 0) {
+		events |= FSM_EVENT(EV_OBSTACLE);
+	}
+	events |= FSM_EVENT(get_slope() ? EV_FLAT : EV_SLOPE);
+
+	fsm_step(&motion, events, timebase_ms());
+
+	if(!CASCADE) { // with the cascaded control, the inner loop drives the motors
+		drive_update(REGUL_PERIOD); // both wheels follow the command with limited acceleration
+	}
+	odometry_update(fsm_in(&motion, ST_ESCAPE), REGUL_PERIOD); // descent performance
+	if(MAP_ROUTING) {
+		map_update(fsm_in(&motion, ST_ESCAPE)); // obstacles met and route around them
+	}
+
+	if(REGUL_LOG) {
+		chprintf((BaseSequentialStream *)&SD3, "REG %u %d %d %d\r\n", timebase_ms(), get_angle(), drive_get_angular(), get_slope());
+	}
+}
+
+/*
+ * gives a transition of the movement states
+ *
+ * \param number	number of the transition since the start (0 for the first),
+ * 					moved to the oldest transition kept if it isn't kept anymore (FSM_LOG_SIZE)
+ *
+ * \param entry		structure to fill
+ *
+ * \return			false if the transition hasn't been taken yet
+ */
+bool motion_get_transition(uint32_t* number, fsm_log_t* entry) {
+	uint32_t oldest = 0; // number of the oldest transition kept
+	bool taken = false;
+
+	chSysLock();
+	oldest = (motion.transitions > FSM_LOG_SIZE) ? motion.transitions - FSM_LOG_SIZE : 0;
+	if(*number < oldest) {
+		*number = oldest;
+	}
+	if(*number < motion.transitions) {
+		taken = fsm_get_log(&motion, *number - oldest, entry);
+	}
+	chSysUnlock();
+
+	return taken;
+}
+
+/*
+ * gives the current movement state
+ *
+ * \return			innermost active state (ST_SLOPE, ST_FLAT or ST_ESCAPE)
+ */
+uint8_t motion_get_state(void) {
+	return motion.current;
+}
+
+/*
+ * sends the last transitions of the movement states, for the diagnostics
+ *
+ * \param out		stream to write to
+ */
+void motion_print(BaseSequentialStream* out) {
+	fsm_log_t entry;
+
+	chprintf(out, "\r\nmovement : %s, %u transitions\r\n", motion_states[motion.current].name, motion.transitions);
+	for(uint8_t i = 0 ; fsm_get_log(&motion, i, &entry) ; i++) {
+		chprintf(out, "%8u ms  %-8s -> %-8s (%s)\r\n", entry.time, motion_states[entry.from].name,
+				motion_states[entry.to].name, motion_events[entry.event]);
+	}
+}
+
 /*
  * movement command thread
- * defines movement mode (normal / escaping)
- * calls the PI regulator in normal mode
- * enters the speed for each motor
- * calls the escape function if a wall is close
- * controls the escape maneuvers duration
  * it's important that the regulator runs at a precise frequency : high priority
  */
-static THD_WORKING_AREA(waRegulator, 256);
+static THD_WORKING_AREA(waRegulator, 1024);
 static THD_FUNCTION(Regulator, arg) {
 
 	chRegSetThreadName(__FUNCTION__);
@@ -185,55 +542,50 @@ static THD_FUNCTION(Regulator, arg) {
 
 	systime_t time;
 
-	bool mode_fonc = NORMAL; // movement mode
-	int8_t prox_alert = 0; // alerts returned by the proximity sensors
-	int16_t steps_to_do = 0; // steps to do to finish an escape maneuver
-	int16_t delta_speed = 0; // speed difference between the motors in normal mode
-	int16_t delta_speed_mean = 0; // averaged speed difference (to smooth the movement)
-
-	// variables used for the moving average
-	int32_t sum_dSpeed = 0;
-	int16_t values_dSpeed[AVERAGE_SIZE_SPEED] = {0};
-	int16_t counter_dSpeed = 0;
-
 	while(1) {
 		time = chVTGetSystemTime();
 
-		// check for proximity alert
-		if(mode_fonc == NORMAL) {
-			prox_alert = get_prox_alert();
-		}
+		regulator_task();
 
-		// state machine to control the movement mode
+		chThdSleepUntilWindowed(time, time + MS2ST(REGUL_PERIOD));
+	}
+}
 
-		if ((mode_fonc == NORMAL) && (prox_alert == 0)) { // normal mode
-			delta_speed = regulator(get_angle(), ANGLE_COMMAND, false); // PI regulator, with the last computed angle
-			delta_speed_mean = average(delta_speed, &sum_dSpeed, values_dSpeed, &counter_dSpeed, AVERAGE_SIZE_SPEED); // moving average of the command
-			// motors command with the regulated and averaged value
-			right_motor_set_speed(SPEED_MOY - delta_speed_mean);
-			left_motor_set_speed(SPEED_MOY + delta_speed_mean);
-
-		} else if ((mode_fonc == NORMAL) && (prox_alert != 0)) { // escape maneuver begins
-			mode_fonc = ESCAPING;
-			steps_to_do = escape(prox_alert); // start of the escape maneuver and storage of the step to do to finish it
-
-		} else if ((mode_fonc == ESCAPING) && (abs(left_motor_get_pos()) >= steps_to_do)) { // escape maneuver ends
-			mode_fonc = NORMAL;
-			delta_speed = regulator(get_angle(), ANGLE_COMMAND, true); // calls the regulator and resets its variable
-			delta_speed_mean = average(delta_speed, &sum_dSpeed, values_dSpeed, &counter_dSpeed, AVERAGE_SIZE_SPEED);
-			right_motor_set_speed(SPEED_MOY - delta_speed_mean);
-			left_motor_set_speed(SPEED_MOY + delta_speed_mean);
-			clear_leds(); // turn the red LEDs off
-		}
+/*
+ * inner loop thread of the cascaded control
+ * shorter period than the regulation : higher priority
+ */
+static THD_WORKING_AREA(waRate, 1024);
+static THD_FUNCTION(Rate, arg) {
 
-		chThdSleepUntilWindowed(time, time + MS2ST(REGUL_PERIOD));
+	chRegSetThreadName(__FUNCTION__);
+	(void)arg;
+
+	systime_t time;
+
+	while(1) {
+		time = chVTGetSystemTime();
+
+		rate_task();
+
+		chThdSleepUntilWindowed(time, time + MS2ST(RATE_PERIOD));
 	}
 }
 
 /*
- * starts the thread dedicated to the regulation
+ * starts the thread dedicated to the regulation (and the inner loop with CASCADE)
+ * with the cyclic executive, the movement command is added to its tasks instead
+ * the offset of the gyroscope used by the cascaded control is measured during the boot (main.c)
  */
 void regulator_start(void){
     motors_init();
-	chThdCreateStatic(waRegulator, sizeof(waRegulator), NORMALPRIO + 1, Regulator, NULL);
+    fsm_init(&motion, motion_states, NB_MOTION_STATES, &motion_table[0][0], NB_MOTION_EVENTS, ST_FLAT, timebase_ms());
+    if(CYCLIC_EXECUTIVE) {
+    	executive_start_control();
+    } else {
+    	chThdCreateStatic(waRegulator, sizeof(waRegulator), NORMALPRIO + 1, Regulator, NULL);
+    	if(CASCADE) {
+    		chThdCreateStatic(waRate, sizeof(waRate), NORMALPRIO + 2, Rate, NULL);
+    	}
+    }
 }
@@ -8,8 +8,24 @@
 #ifndef REGULATION_H_
 #define REGULATION_H_
 
-int16_t regulator(int16_t mesured_angle, int16_t angle_to_reach, bool reset);
-int32_t escape(int8_t alert_number);
+#include <hal.h>
+#include <angle.h>
+#include <fsm.h>
+#include <prox.h>
+#include <control.h>
+
+#define CASCADE false // true for the cascaded control : the heading error gives a yaw rate, followed with the gyroscope by a faster inner loop
+
+int16_t regulator(heading_t mesured_angle, heading_t angle_to_reach, uint8_t mode);
+int16_t cruise_speed(heading_t err, int16_t delta_speed);
+float yaw_rate_command(heading_t err);
+void rate_task(void);
+int32_t escape(int8_t alert_number, const prox_obstacle_t* obstacle);
+void regulator_task(void);
 void regulator_start(void);
+void get_regulator_terms(regul_terms_t* last);
+bool motion_get_transition(uint32_t* number, fsm_log_t* entry);
+uint8_t motion_get_state(void);
+void motion_print(BaseSequentialStream* out);
 
 #endif /* REGULATION_H_ */
@@ -0,0 +1,80 @@
+/*
+ * timebase.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <timebase.h>
+
+/*
+ * Monotonic time [us] since timebase_start(), on 64 bit : the time source of the measurements, the logs and the
+ * time stamps of the samples (the system time only has 1 ms)
+ * Timer 12 (1 MHz, 16 bit) gives the microseconds, the number of its overflows is counted by its interrupt.
+ * The overflow can happen while the time is read, before its interrupt is served : the update flag of the timer
+ * tells it, the counter is then read again after the overflow.
+ * The read is done in a critical zone, from a thread or an interrupt (not from a fast interrupt, above the kernel)
+ */
+
+// update flag of timer 12 : set by the overflow, cleared when its interrupt is served
+#ifndef gptIsWrapPendingX
+#define gptIsWrapPendingX(gptp) (((gptp)->tim->SR & STM32_TIM_SR_UIF) != 0)
+#endif
+
+static volatile uint32_t wraps = 0; // overflows of timer 12 served
+
+/*
+ * interrupt of timer 12, at each overflow
+ */
+static void timebase_wrap(GPTDriver* gptp) {
+	(void)gptp;
+
+	chSysLockFromISR();
+	wraps++;
+	chSysUnlockFromISR();
+}
+
+/*
+ * starts timer 12 and its overflow interrupt
+ */
+void timebase_start(void) {
+	static const GPTConfig gpt12cfg = {
+		1000000,        /* 1MHz timer clock in order to measure uS.*/
+		timebase_wrap,  /* counts the overflows.*/
+		0,
+		0
+	};
+
+	gptStart(&GPTD12, &gpt12cfg);
+	// the counter goes from 0 to TIMEBASE_WRAP - 1
+	gptStartContinuous(&GPTD12, TIMEBASE_WRAP);
+}
+
+/*
+ * \return	time since timebase_start() [us]
+ */
+uint64_t timebase_us(void) {
+	syssts_t status = chSysGetStatusAndLockX();
+	uint32_t high = wraps;
+	uint16_t count = gptGetCounterX(&GPTD12);
+
+	if(gptIsWrapPendingX(&GPTD12)) {
+		// overflow not served yet : the counter read may be before or after it, it is read again after
+		count = gptGetCounterX(&GPTD12);
+		high++;
+	}
+	chSysRestoreStatusX(status);
+
+	return (uint64_t)high * TIMEBASE_WRAP + count;
+}
+
+/*
+ * \return	time since timebase_start() [ms], wraps around after 49 days
+ */
+uint32_t timebase_ms(void) {
+	return timebase_us() / 1000;
+}
@@ -0,0 +1,19 @@
+/*
+ * timebase.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+#include <hal.h>
+
+#define TIMEBASE_WRAP 0xFFFF // values of timer 12 (1 MHz) : it counts from 0 to TIMEBASE_WRAP - 1 [us]
+
+void timebase_start(void);
+uint64_t timebase_us(void);
+uint32_t timebase_ms(void);
+
+#endif /* TIMEBASE_H_ */
@@ -0,0 +1,145 @@
+/*
+ * trace.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <chprintf.h>
+#include <trace.h>
+#include <timebase.h>
+
+/*
+ * Scheduler trace
+ * The kernel trace (CH_DBG_ENABLE_TRACE) only has a 1 ms resolution, too coarse for the tasks of the robot (a few us)
+ * With TRACE_DUMP, each context switch is also recorded here with the time base (1 us) by CH_CFG_CONTEXT_SWITCH_HOOK (chconf.h)
+ * trace_dump() sends both traces and the threads statistics, tools/trace_timeline.py draws the timeline
+ *
+ * Lines sent :
+ *   TRACE BEGIN <system time [ms]>
+ *   THREAD <address> <name> <priority> <run time [ms]> <switches> <best> <worst> <cumulative [cycles]>
+ *   KSTAT <interrupts> <context switches>
+ *   KTRACE <time [ms]> <thread in> <state of the thread out>
+ *   SWITCH <time [ms]> <time base [us], 32 bit> <thread in> <state of the thread out> <interrupts since the last switch>
+ *   TRACE END
+ */
+
+#define TRACE_SIZE 256 // number of context switches kept
+
+// context switch
+typedef struct {
+	systime_t time;		// system time [ms], to match the kernel trace
+	uint32_t us;		// time base [us], wraps around after 71 min
+	uint8_t state;		// state of the thread switched out (CH_STATE_READY if it was preempted)
+	uint8_t irqs;		// interrupts since the previous switch
+	thread_t* tp;		// thread switched in
+} trace_event_t;
+
+static trace_event_t events[TRACE_SIZE]; // circular buffer
+static uint16_t next = 0; // position of the next event
+static bool full = false; // true when the buffer has been filled once
+static uint32_t irqs_last = 0; // number of interrupts at the last switch
+
+static trace_event_t copy[TRACE_SIZE]; // copy sent by trace_dump(), so that the trace continues during the dump
+
+/*
+ * records a context switch, called by the kernel in a critical zone
+ *
+ * \param ntp		thread switched in
+ *
+ * \param otp		thread switched out
+ */
+void trace_switch(void* ntp, void* otp) {
+	trace_event_t* e = &events[next];
+
+	e->time = chVTGetSystemTimeX();
+	e->us = timebase_us();
+	e->state = ((thread_t*)otp)->p_state;
+	e->irqs = ch.kernel_stats.n_irq - irqs_last;
+	e->tp = ntp;
+	irqs_last = ch.kernel_stats.n_irq;
+
+	next++;
+	if(next == TRACE_SIZE) {
+		next = 0;
+		full = true;
+	}
+}
+
+/*
+ * sends the traces and the threads statistics
+ *
+ * \param out		stream to write to (serial port)
+ */
+void trace_dump(BaseSequentialStream* out) {
+	static ch_trace_buffer_t ktrace; // copy of the kernel trace
+	uint16_t first = 0;
+	uint16_t kfirst = 0; // oldest event of the kernel trace
+	uint16_t nb = 0;
+	thread_t* tp = NULL;
+
+	// copies of both traces, in order from the oldest event
+	chSysLock();
+	first = full ? next : 0;
+	nb = full ? TRACE_SIZE : next;
+	for(uint16_t i = 0 ; i < nb ; i++) {
+		copy[i] = events[(first + i) % TRACE_SIZE];
+	}
+	ktrace = ch.dbg.trace_buffer;
+	kfirst = ch.dbg.trace_buffer.tb_ptr - ch.dbg.trace_buffer.tb_buffer;
+	chSysUnlock();
+
+	chprintf(out, "TRACE BEGIN %u\r\n", ST2MS(chVTGetSystemTime()));
+
+	tp = chRegFirstThread();
+	while(tp != NULL) {
+		chprintf(out, "THREAD %x %s %u %u %u %u %u %u\r\n", (uint32_t)tp, tp->p_name, tp->p_prio, ST2MS(tp->p_time),
+				tp->p_stats.n, tp->p_stats.best, tp->p_stats.worst, (uint32_t)tp->p_stats.cumulative);
+		tp = chRegNextThread(tp);
+	}
+
+	chprintf(out, "KSTAT %u %u\r\n", ch.kernel_stats.n_irq, ch.kernel_stats.n_ctxswc);
+
+	// kernel trace, from the oldest event
+	for(uint16_t i = 0 ; i < ktrace.tb_size ; i++) {
+		ch_swc_event_t* e = &ktrace.tb_buffer[(kfirst + i) % ktrace.tb_size];
+		if(e->se_tp != NULL) {
+			chprintf(out, "KTRACE %u %x %u\r\n", ST2MS(e->se_time), (uint32_t)e->se_tp, e->se_state);
+		}
+	}
+
+	for(uint16_t i = 0 ; i < nb ; i++) {
+		chprintf(out, "SWITCH %u %u %x %u %u\r\n", ST2MS(copy[i].time), copy[i].us, (uint32_t)copy[i].tp, copy[i].state, copy[i].irqs);
+	}
+
+	chprintf(out, "TRACE END\r\n");
+}
+
+/*
+ * sends the stack never used by each thread since its creation (high-water mark)
+ * the working areas are filled with CH_DBG_STACK_FILL_VALUE at the creation (CH_DBG_FILL_THREADS in chconf.h) :
+ * the bytes still equal to it above the limit of the stack have never been written
+ * the stacks grow down to p_stklimit (CH_DBG_ENABLE_STACK_CHECK, not in the simulation), the margin is the distance to it
+ *
+ * \param out		stream to write to
+ */
+void trace_stacks(BaseSequentialStream* out) {
+#if CH_DBG_ENABLE_STACK_CHECK == TRUE && CH_DBG_FILL_THREADS == TRUE
+	thread_t* tp = chRegFirstThread();
+	const uint8_t* p = NULL;
+
+	chprintf(out, "\r\nstacks : bytes never used\r\n");
+	while(tp != NULL) {
+		for(p = (const uint8_t*)tp->p_stklimit ; *p == CH_DBG_STACK_FILL_VALUE ; p++) {
+		}
+		chprintf(out, "%-20s %5u\r\n", tp->p_name, (uint32_t)(p - (const uint8_t*)tp->p_stklimit));
+		tp = chRegNextThread(tp);
+	}
+#else
+	chprintf(out, "\r\nstacks : not measured (CH_DBG_ENABLE_STACK_CHECK and CH_DBG_FILL_THREADS needed)\r\n");
+#endif
+}
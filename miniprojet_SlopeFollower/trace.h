@@ -0,0 +1,20 @@
+/*
+ * trace.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <hal.h>
+
+// TRACE_DUMP is in chconf.h : without the trace, the context switch hook does nothing
+#define TRACE_DUMP_PERIOD 10 // period of the scheduler trace on the serial port [s]
+
+void trace_switch(void* ntp, void* otp);
+void trace_dump(BaseSequentialStream* out);
+void trace_stacks(BaseSequentialStream* out);
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,755 @@
+/*
+ * batch.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <average.h>
+#include <estimate.h>
+#include <control.h>
+
+/*
+ * Batch simulation of many robots for the sweeps (slope, initial angle), without the kernel
+ *
+ * Each tick (real fast period of the angle computation) does the same steps as the firmware on the robot :
+ *   plant : the wheels move the robot, the body follows with the yaw model (SIM_YAW_GAIN, SIM_YAW_TAU)
+ *   sense : accelerations of the slope with noise, after the calibration
+ *   estimate : estimate_update() of compute_angle() (moving averages of the inclination and of the angle)
+ *   control, at the first tick after each REGUL_PERIOD : regulator_step() (PI with ARW), average of the command, speed_schedule()
+ *     and drive_update() (acceleration and jerk limits)
+ * The arena has no wall and no obstacle : the proximity sensors and the escape maneuvers aren't simulated
+ *
+ * Two versions of the same step :
+ *   scalar : one robot after the other, with the code of the firmware : estimate.c, control.c and average.c
+ *     are compiled in the batch, only the sequence of drive_run() is written again here
+ *   batch : structure of arrays, each step is a loop over all the robots without branches that the compiler
+ *     vectorizes (AVX2 on the host, NEON on ARM), the conditions are selects on the bits (select_f()),
+ *     the moving averages of all the robots share their position
+ * Both versions share the plant and the noise (xorshift per robot, sum of 4 uniforms, sine by a polynomial),
+ * so that only the firmware path is compared. With BATCH_EXACT, atanf() of the C library is called in a loop
+ * of its own and both versions are bit-exact. Otherwise the batch uses a polynomial (error < 2e-7 rad),
+ * far under the resolution of a heading (0.01 deg) : rare roundings differ, then the paths of these robots
+ * move apart (up to 20 deg and 70 mm in 30 s) and the comparison fails, only the speed is measured.
+ *
+ * usage : slopefollower_batch [robots (4096)] [simulated time [s] (30)]
+ * The robots are spread over SLOPE_MIN to SLOPE_MAX and all the initial angles. Printed :
+ *   robot-ticks per second (one core) of both versions, differences of the batch with the scalar version
+ *   (estimates, commands, final positions), robots that reached the bottom of the slope
+ * Returns 1 if a difference is above its tolerance (TOL_*) : the batch doesn't run the code of the firmware anymore
+ */
+
+// the constants of the firmware come from estimate.h and control.h, these ones are private to its files
+#define PI 3.14159f // estimate.c
+// period of the angle computation [ms] : COMPUTE_ANGLE_PERIOD, IMU_PERIOD, IMU_TOPIC (angle.c) and CYCLIC_EXECUTIVE
+// (executive.h) are read in the sources by the Makefile, as ANGLE_PERIOD_FAST of angle.c (ADAPTIVE_PERIOD false)
+#define TICK ANGLE_PERIOD_REAL(COMPUTE_ANGLE_PERIOD, IMU_PERIOD, IMU_TOPIC && !CYCLIC_EXECUTIVE)
+#define AVERAGE_ANGLE_SIZE AVERAGE_SIZE(AVERAGE_ANGLE_TIME, TICK)
+#define AVERAGE_SLOPE_SIZE AVERAGE_SIZE(AVERAGE_SLOPE_TIME, TICK)
+AVERAGE_SIZE_CHECK(AVERAGE_ANGLE_SIZE);
+AVERAGE_SIZE_CHECK(AVERAGE_SLOPE_SIZE);
+
+// plant (plant.c)
+#define PI_F 3.14159265f
+#define DEG_TO_RAD (PI_F / 180)
+#define STEP_MM 0.13f
+#define WHEEL_BASE 53.f
+#define ACC_1G 16384
+#define ACC_NOISE 40.f
+
+// batch
+#define BATCH_EXACT true // true to call atanf() of the C library in the batch : bit-exact, the angle loop isn't vectorized
+#define TOL_ESTIMATE 0 // largest difference of the estimates with the scalar version [heading]
+#define TOL_COMMAND 0 // [step/s]
+#define TOL_POSITION 0.f // [mm]
+#define CONTROL_TICK(tick) (((tick) + 1) * TICK / REGUL_PERIOD != (tick) * TICK / REGUL_PERIOD) // a REGUL_PERIOD ends in this tick
+#define SLOPE_MIN 5 // [deg]
+#define SLOPE_MAX 30
+#define START_Y 1350.f // [mm] above the bottom of the slope (plant.c : SIM_LENGTH - 150)
+#define RUNOUT 400.f
+#define CHECK_ROBOTS 512 // robots compared tick by tick with the scalar version, spread over the sweep
+#define ALIGN 64
+
+// parameters of the sweep, same for both versions
+typedef struct {
+	float sin_incl;
+	float cos_incl;
+	float heading; // initial heading in the arena [rad]
+	uint32_t seed;
+} robot_param_t;
+
+// yaw model of the surface (plant.c)
+static float yaw_gain = 1;
+static float yaw_tau = 0; // [ms]
+
+/*
+ * shared by both versions : noise and trigonometry of the plant, written to be vectorized
+ */
+
+static inline uint32_t xorshift(uint32_t s) {
+	s ^= s << 13;
+	s ^= s >> 17;
+	s ^= s << 5;
+	return s;
+}
+
+static inline float uniform(uint32_t s) {
+	return (float)(s >> 8) * (1.f / 16777216);
+}
+
+/*
+ * cond ? a : b on the bits, like a blend of the vector units
+ * with c ? a : b, gcc moves the computation of a and b in branches, which can't be vectorized
+ * without masks (AVX2, NEON) as long as the floating point operations may trap
+ */
+static inline float select_f(bool cond, float a, float b) {
+	union { float f; uint32_t u; } va = {a}, vb = {b};
+	uint32_t mask = -(uint32_t)cond;
+
+	va.u = (va.u & mask) | (vb.u & ~mask);
+	return va.f;
+}
+
+/*
+ * sine on any angle : reduction to [-pi/2, pi/2] and polynomial (error < 1e-6)
+ */
+static inline float sin_poly(float a) {
+	float k = (float)(int32_t)(a * (1 / (2 * PI_F)) + (a >= 0 ? 0.5f : -0.5f));
+	float r = a - k * (2 * PI_F);
+	float above = PI_F - r;
+	float below = -PI_F - r;
+	float r2 = 0;
+
+	r = select_f(r > PI_F / 2, above, r);
+	r = select_f(r < -PI_F / 2, below, r);
+	r2 = r * r;
+	return r * (1 + r2 * (-1.f / 6 + r2 * (1.f / 120 + r2 * (-1.f / 5040 + r2 * (1.f / 362880)))));
+}
+
+static inline float cos_poly(float a) {
+	return sin_poly(a + PI_F / 2);
+}
+
+/*
+ * arc tangent, reduction of cephes atanf and polynomial (error < 2e-7 rad)
+ */
+static inline float atan_poly(float x) {
+	float ax = fabsf(x);
+	bool big = ax > 2.414213562f;
+	bool mid = ax > 0.414213562f;
+	float offset = big ? PI_F / 2 : (mid ? PI_F / 4 : 0);
+	float inv = -1 / ax;
+	float shifted = (ax - 1) / (ax + 1);
+	float r = select_f(big, inv, select_f(mid, shifted, ax));
+	float z = r * r;
+	float y = offset + ((((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z
+			- 3.33329491539e-1f) * z * r + r);
+
+	return select_f(x < 0, -y, y);
+}
+
+/*
+ * roundf() without a call : half away from zero
+ */
+static inline float round_v(float x) {
+	float t = (float)(int32_t)x;
+	float frac = x - t;
+
+	return t + ((frac >= 0.5f) ? 1 : ((frac <= -0.5f) ? -1 : 0));
+}
+
+/*
+ * scalar version : state of one robot and the code of the firmware
+ */
+
+typedef struct {
+	// plant
+	float x;
+	float y;
+	float heading;
+	float diff_body;
+	float sin_incl;
+	float cos_incl;
+	uint32_t seed;
+	int16_t left_speed;
+	int16_t right_speed;
+	// compute_angle() of angle.c
+	estimate_t estimate;
+	// regulator() and drive_run() of regulation.c
+	regul_t regul;
+	int32_t sum_dspeed;
+	int16_t values_dspeed[AVERAGE_SIZE_SPEED];
+	int16_t counter_dspeed;
+	bool resume;
+	int16_t delta_mean;
+	// drive.c
+	axis_t linear;
+	axis_t angular;
+} robot_t;
+
+static void robot_init(robot_t* r, const robot_param_t* p) {
+	memset(r, 0, sizeof(*r));
+	r->y = START_Y;
+	r->heading = p->heading;
+	r->sin_incl = p->sin_incl;
+	r->cos_incl = p->cos_incl;
+	r->seed = p->seed;
+	r->estimate = (estimate_t)ESTIMATE_INIT(AVERAGE_ANGLE_SIZE, AVERAGE_SLOPE_SIZE);
+	r->regul = (regul_t)REGUL_INIT;
+	r->resume = true; // drive_entry()
+}
+
+static void plant_step(robot_t* r) {
+	float dt = TICK / 1000.f;
+	float diff = (r->left_speed - r->right_speed) / 2.f;
+	float distance = (r->left_speed + r->right_speed) * dt / 2 * STEP_MM;
+
+	r->diff_body += (yaw_gain * diff - r->diff_body) * TICK / (yaw_tau + TICK);
+	r->heading += -2 * r->diff_body * STEP_MM / WHEEL_BASE * dt;
+	r->x += distance * cos_poly(r->heading);
+	r->y += distance * sin_poly(r->heading);
+}
+
+static float gauss(uint32_t* seed) {
+	float sum = 0;
+
+	for(uint8_t i = 0 ; i < 4 ; i++) {
+		*seed = xorshift(*seed);
+		sum += uniform(*seed);
+	}
+	return (sum - 2) * 1.7320508f;
+}
+
+// accelerations after the calibration on a flat table
+static void sense(robot_t* r, int16_t* acc) {
+	float sin_incl = (r->y >= 0) ? r->sin_incl : 0;
+	float one_cos = (r->y >= 0) ? 1 - r->cos_incl : 0;
+	float angle = r->heading + PI_F / 2;
+	float nx = gauss(&r->seed);
+	float ny = gauss(&r->seed);
+	float nz = gauss(&r->seed);
+
+	acc[0] = -ACC_1G * sin_incl * sin_poly(angle) + ACC_NOISE * nx;
+	acc[1] = -ACC_1G * sin_incl * cos_poly(angle) + ACC_NOISE * ny;
+	acc[2] = ACC_1G * one_cos + ACC_NOISE * nz;
+}
+
+// drive_run() and drive_update() : HEADING_COMMAND 0, no steering, no obstacle
+static void control(robot_t* r) {
+	heading_t err = heading_diff(r->estimate.angle, 0);
+	int16_t delta_speed = 0;
+	float dt = REGUL_PERIOD / 1000.f;
+
+	if(r->resume) {
+		delta_speed = regulator_step(&r->regul, r->estimate.angle, 0, REGUL_RESUME);
+		r->delta_mean = average_fill(delta_speed, &r->sum_dspeed, r->values_dspeed, &r->counter_dspeed, AVERAGE_SIZE_SPEED);
+	} else {
+		delta_speed = regulator_step(&r->regul, r->estimate.angle, 0, r->estimate.flat ? REGUL_RESET : REGUL_RUN);
+		r->delta_mean = average(delta_speed, &r->sum_dspeed, r->values_dspeed, &r->counter_dspeed, AVERAGE_SIZE_SPEED);
+	}
+	r->resume = false;
+	r->linear.command = speed_schedule(err, r->delta_mean, r->estimate.inclination, 0);
+	r->angular.command = r->delta_mean;
+
+	axis_update(&r->linear, ACC_MAX_LINEAR, JERK_MAX_LINEAR, dt);
+	axis_update(&r->angular, ACC_MAX_ANGULAR, JERK_MAX_ANGULAR, dt);
+	r->left_speed = r->linear.speed + r->angular.speed;
+	r->right_speed = r->linear.speed - r->angular.speed;
+}
+
+static void robot_step(robot_t* r, uint32_t tick) {
+	int16_t acc[3] = {0};
+
+	plant_step(r);
+	sense(r, acc);
+	estimate_update(&r->estimate, acc);
+	if(CONTROL_TICK(tick)) {
+		control(r);
+	}
+}
+
+/*
+ * batch version : structure of arrays, index i is the robot
+ * the history of the moving averages is values[position * n + i]
+ */
+
+typedef struct {
+	uint32_t n;
+	// plant
+	float* x;
+	float* y;
+	float* heading;
+	float* diff_body;
+	float* sin_incl;
+	float* cos_incl;
+	uint32_t* seed;
+	int16_t* left_speed;
+	int16_t* right_speed;
+	// sense
+	int16_t* acc_x;
+	int16_t* acc_y;
+	int16_t* acc_z;
+	float* ratio; // acc_y / acc_x, for the arc tangent
+	float* atan;
+	// estimate
+	int32_t* sum_slope;
+	int16_t* values_slope;
+	int16_t counter_slope;
+	int32_t* sum_angle;
+	int16_t* values_angle;
+	int16_t counter_angle;
+	heading_t* angle_mean;
+	uint8_t* flat;
+	int16_t* incl_mean;
+	// control
+	float* integr;
+	int32_t* sum_dspeed;
+	int16_t* values_dspeed;
+	int16_t counter_dspeed;
+	bool resume;
+	int16_t* delta_mean;
+	float* lin_cmd;
+	float* lin_speed;
+	float* lin_acc;
+	float* ang_cmd;
+	float* ang_speed;
+	float* ang_acc;
+} batch_t;
+
+static void* batch_alloc(uint32_t n, size_t size) {
+	size_t bytes = (n * size + ALIGN - 1) / ALIGN * ALIGN;
+	void* p = NULL;
+
+	if(posix_memalign(&p, ALIGN, bytes) != 0) {
+		fprintf(stderr, "not enough memory for %u robots\n", n);
+		exit(1);
+	}
+	memset(p, 0, bytes);
+	return p;
+}
+
+static void batch_init(batch_t* b, const robot_param_t* param, uint32_t n) {
+	memset(b, 0, sizeof(*b));
+	b->n = n;
+	b->x = batch_alloc(n, sizeof(float));
+	b->y = batch_alloc(n, sizeof(float));
+	b->heading = batch_alloc(n, sizeof(float));
+	b->diff_body = batch_alloc(n, sizeof(float));
+	b->sin_incl = batch_alloc(n, sizeof(float));
+	b->cos_incl = batch_alloc(n, sizeof(float));
+	b->seed = batch_alloc(n, sizeof(uint32_t));
+	b->left_speed = batch_alloc(n, sizeof(int16_t));
+	b->right_speed = batch_alloc(n, sizeof(int16_t));
+	b->acc_x = batch_alloc(n, sizeof(int16_t));
+	b->acc_y = batch_alloc(n, sizeof(int16_t));
+	b->acc_z = batch_alloc(n, sizeof(int16_t));
+	b->ratio = batch_alloc(n, sizeof(float));
+	b->atan = batch_alloc(n, sizeof(float));
+	b->sum_slope = batch_alloc(n, sizeof(int32_t));
+	b->values_slope = batch_alloc(n * AVERAGE_SLOPE_SIZE, sizeof(int16_t));
+	b->sum_angle = batch_alloc(n, sizeof(int32_t));
+	b->values_angle = batch_alloc(n * AVERAGE_ANGLE_SIZE, sizeof(int16_t));
+	b->angle_mean = batch_alloc(n, sizeof(heading_t));
+	b->flat = batch_alloc(n, sizeof(uint8_t));
+	b->incl_mean = batch_alloc(n, sizeof(int16_t));
+	b->integr = batch_alloc(n, sizeof(float));
+	b->sum_dspeed = batch_alloc(n, sizeof(int32_t));
+	b->values_dspeed = batch_alloc(n * AVERAGE_SIZE_SPEED, sizeof(int16_t));
+	b->delta_mean = batch_alloc(n, sizeof(int16_t));
+	b->lin_cmd = batch_alloc(n, sizeof(float));
+	b->lin_speed = batch_alloc(n, sizeof(float));
+	b->lin_acc = batch_alloc(n, sizeof(float));
+	b->ang_cmd = batch_alloc(n, sizeof(float));
+	b->ang_speed = batch_alloc(n, sizeof(float));
+	b->ang_acc = batch_alloc(n, sizeof(float));
+
+	for(uint32_t i = 0 ; i < n ; i++) {
+		b->y[i] = START_Y;
+		b->heading[i] = param[i].heading;
+		b->sin_incl[i] = param[i].sin_incl;
+		b->cos_incl[i] = param[i].cos_incl;
+		b->seed[i] = param[i].seed;
+		b->flat[i] = true;
+	}
+	b->resume = true;
+}
+
+static void batch_free(batch_t* b) {
+	void* arrays[] = {b->x, b->y, b->heading, b->diff_body, b->sin_incl, b->cos_incl, b->seed, b->left_speed,
+			b->right_speed, b->acc_x, b->acc_y, b->acc_z, b->ratio, b->atan, b->sum_slope, b->values_slope,
+			b->sum_angle, b->values_angle, b->angle_mean, b->flat, b->incl_mean, b->integr, b->sum_dspeed,
+			b->values_dspeed, b->delta_mean, b->lin_cmd, b->lin_speed, b->lin_acc, b->ang_cmd, b->ang_speed,
+			b->ang_acc};
+
+	for(uint8_t i = 0 ; i < sizeof(arrays) / sizeof(arrays[0]) ; i++) {
+		free(arrays[i]);
+	}
+}
+
+static void batch_plant_sense(batch_t* b) {
+	const uint32_t n = b->n;
+	const float dt = TICK / 1000.f;
+	float* x = b->x;
+	float* y = b->y;
+	float* heading = b->heading;
+	float* diff_body = b->diff_body;
+	const float* sin_incl = b->sin_incl;
+	const float* cos_incl = b->cos_incl;
+	uint32_t* seed = b->seed;
+	const int16_t* left_speed = b->left_speed;
+	const int16_t* right_speed = b->right_speed;
+	int16_t* acc_x = b->acc_x;
+	int16_t* acc_y = b->acc_y;
+	int16_t* acc_z = b->acc_z;
+	float* ratio = b->ratio;
+
+	#pragma GCC ivdep
+	for(uint32_t i = 0 ; i < n ; i++) {
+		float diff = (left_speed[i] - right_speed[i]) / 2.f;
+		float distance = (left_speed[i] + right_speed[i]) * dt / 2 * STEP_MM;
+		float body = diff_body[i] + (yaw_gain * diff - diff_body[i]) * TICK / (yaw_tau + TICK);
+		float h = heading[i] + -2 * body * STEP_MM / WHEEL_BASE * dt;
+		float yi = y[i] + distance * sin_poly(h);
+		float on_slope = select_f(yi >= 0, sin_incl[i], 0);
+		float one_cos = select_f(yi >= 0, 1 - cos_incl[i], 0);
+		float noise[3];
+		uint32_t s = seed[i];
+
+		for(uint8_t axis = 0 ; axis < 3 ; axis++) {
+			float sum = 0;
+			for(uint8_t k = 0 ; k < 4 ; k++) {
+				s = xorshift(s);
+				sum += uniform(s);
+			}
+			noise[axis] = (sum - 2) * 1.7320508f;
+		}
+
+		diff_body[i] = body;
+		heading[i] = h;
+		x[i] += distance * cos_poly(h);
+		y[i] = yi;
+		seed[i] = s;
+		acc_x[i] = -ACC_1G * on_slope * sin_poly(h + PI_F / 2) + ACC_NOISE * noise[0];
+		acc_y[i] = -ACC_1G * on_slope * cos_poly(h + PI_F / 2) + ACC_NOISE * noise[1];
+		acc_z[i] = ACC_1G * one_cos + ACC_NOISE * noise[2];
+		ratio[i] = ((float)acc_y[i]) / ((float)acc_x[i]);
+	}
+}
+
+static void batch_estimate(batch_t* b) {
+	const uint32_t n = b->n;
+	const int16_t* acc_x = b->acc_x;
+	const int16_t* acc_y = b->acc_y;
+	const int16_t* acc_z = b->acc_z;
+	const float* ratio = b->ratio;
+	float* atan = b->atan;
+	int32_t* sum_slope = b->sum_slope;
+	int16_t* values_slope = b->values_slope + b->counter_slope * n;
+	int32_t* sum_angle = b->sum_angle;
+	int16_t* values_angle = b->values_angle + b->counter_angle * n;
+	heading_t* angle_mean = b->angle_mean;
+	uint8_t* flat = b->flat;
+	int16_t* incl_mean = b->incl_mean;
+
+	if(BATCH_EXACT) {
+		#pragma GCC ivdep
+		for(uint32_t i = 0 ; i < n ; i++) {
+			atan[i] = atanf(ratio[i]);
+		}
+	} else {
+		#pragma GCC ivdep
+		for(uint32_t i = 0 ; i < n ; i++) {
+			atan[i] = atan_poly(ratio[i]);
+		}
+	}
+
+	#pragma GCC ivdep
+	for(uint32_t i = 0 ; i < n ; i++) {
+		int32_t sum = sum_slope[i] - values_slope[i] + acc_z[i];
+		int16_t z_mean = sum / AVERAGE_SLOPE_SIZE;
+		float scaled = (HEADING_HALF_TURN/PI) * atan[i];
+		heading_t angle = round_v(scaled);
+		bool slope = z_mean > INCL_LIMIT;
+		bool dial = (acc_x[i] != 0) & (acc_y[i] != 0);
+
+		angle = !dial ? angle : (acc_x[i] > 0 ? -angle - HEADING_HALF_TURN/2 : -angle + HEADING_HALF_TURN/2);
+		angle = slope ? angle : 0;
+
+		sum_slope[i] = sum;
+		values_slope[i] = acc_z[i];
+		incl_mean[i] = z_mean;
+		flat[i] = !slope;
+
+		sum = sum_angle[i] - values_angle[i] + angle;
+		sum_angle[i] = sum;
+		values_angle[i] = angle;
+		angle_mean[i] = sum / AVERAGE_ANGLE_SIZE;
+	}
+	b->counter_slope = (b->counter_slope + 1) % AVERAGE_SLOPE_SIZE;
+	b->counter_angle = (b->counter_angle + 1) % AVERAGE_ANGLE_SIZE;
+}
+
+// ratio() as a clamp : the division isn't in a branch
+static inline float ratio_v(int32_t value, int32_t low, int32_t high) {
+	float r = (float)(value - low) / (high - low);
+
+	r = select_f(r < 0, 0, r);
+	return select_f(r > 1, 1, r);
+}
+
+static inline void axis_v(float cmd, float* speed, float* acc, float acc_max, float jerk_max, float dt) {
+	float err = cmd - *speed;
+	float acc_step = jerk_max * dt;
+	float wanted = sqrtf(2 * jerk_max * fabsf(err));
+	float a = *acc;
+	float s = 0;
+	bool reached = false;
+
+	wanted = select_f(wanted > acc_max, acc_max, wanted);
+	wanted = select_f(err < 0, -wanted, wanted);
+	a = select_f(wanted > a + acc_step, a + acc_step, select_f(wanted < a - acc_step, a - acc_step, wanted));
+	s = *speed + a * dt;
+	reached = ((err >= 0) & (s >= cmd)) | ((err <= 0) & (s <= cmd)); // no branch
+	*speed = select_f(reached, cmd, s);
+	*acc = select_f(reached, 0, a);
+}
+
+static void batch_control(batch_t* b) {
+	const uint32_t n = b->n;
+	const float dt = REGUL_PERIOD / 1000.f;
+	const bool resume = b->resume;
+	const int32_t keep = resume ? 0 : -1;
+	const heading_t* angle_mean = b->angle_mean;
+	const uint8_t* flat = b->flat;
+	const int16_t* incl_mean = b->incl_mean;
+	float* integr = b->integr;
+	int32_t* sum_dspeed = b->sum_dspeed;
+	int16_t* values_dspeed = b->values_dspeed + b->counter_dspeed * n;
+	int16_t* delta_mean = b->delta_mean;
+	float* lin_cmd = b->lin_cmd;
+	float* lin_speed = b->lin_speed;
+	float* lin_acc = b->lin_acc;
+	float* ang_cmd = b->ang_cmd;
+	float* ang_speed = b->ang_speed;
+	float* ang_acc = b->ang_acc;
+	int16_t* left_speed = b->left_speed;
+	int16_t* right_speed = b->right_speed;
+
+	#pragma GCC ivdep
+	for(uint32_t i = 0 ; i < n ; i++) {
+		heading_t err = angle_mean[i];
+		bool reset = (!resume) & flat[i];
+		int32_t old = values_dspeed[i];
+		float in = integr[i];
+		float prop = KP * (float)err / HEADING_SCALE;
+		float output = 0;
+		float clamped = 0;
+		float back = 0;
+		int16_t delta_speed = 0;
+		int16_t mean = 0;
+		int32_t sum = 0;
+		float slow = 0;
+		float slow_err = 0;
+		int16_t speed = 0;
+		int16_t room = 0;
+
+		// regulator()
+		in = select_f(reset, 0, in);
+		in += KI * (float)((abs(err) < INTEGR_BAND * HEADING_SCALE) ? err : 0) / HEADING_SCALE; // + 0 : exact
+		output = prop + in;
+		clamped = select_f(output > SPEED_MAX, SPEED_MAX, select_f(output < -SPEED_MAX, -SPEED_MAX, output));
+		delta_speed = clamped;
+		back = in + KAW * (clamped - output);
+		in = select_f((back > 0) != (in > 0), 0, back); // the back-calculation stops at 0
+		integr[i] = in;
+
+		// average() or average_fill() of the command, the position is the same for all the robots
+		sum = sum_dspeed[i] - old + delta_speed;
+		sum = (sum & keep) | ((int32_t)delta_speed * AVERAGE_SIZE_SPEED & ~keep); // resume ? fill : sum, without branch
+		mean = sum / AVERAGE_SIZE_SPEED;
+		sum_dspeed[i] = sum;
+		values_dspeed[i] = delta_speed;
+		delta_mean[i] = mean;
+
+		// cruise_speed()
+		slow_err = ratio_v(abs(err), ERR_SMALL * HEADING_SCALE, ERR_BIG * HEADING_SCALE);
+		slow = ratio_v(incl_mean[i], INCL_GENTLE, INCL_STEEP) * SLOW_STEEP;
+		slow = select_f(slow_err > slow, slow_err, slow);
+		speed = SPEED_CRUISE_MAX - slow * (SPEED_CRUISE_MAX - SPEED_CRUISE_MIN);
+		room = SPEED_MAX - abs(mean);
+		speed = (speed > room) ? room : speed;
+		speed = SPEED_SCHEDULING ? speed : SPEED_MOY;
+
+		// drive_update()
+		lin_cmd[i] = speed;
+		ang_cmd[i] = mean;
+		axis_v(lin_cmd[i], &lin_speed[i], &lin_acc[i], ACC_MAX_LINEAR, JERK_MAX_LINEAR, dt);
+		axis_v(ang_cmd[i], &ang_speed[i], &ang_acc[i], ACC_MAX_ANGULAR, JERK_MAX_ANGULAR, dt);
+		left_speed[i] = lin_speed[i] + ang_speed[i];
+		right_speed[i] = lin_speed[i] - ang_speed[i];
+	}
+
+	if(resume) {
+		// average_fill() : the whole history is the first command
+		for(int16_t k = 0 ; k < AVERAGE_SIZE_SPEED ; k++) {
+			memcpy(b->values_dspeed + k * n, values_dspeed, n * sizeof(int16_t));
+		}
+		b->counter_dspeed = 0;
+	} else {
+		b->counter_dspeed = (b->counter_dspeed + 1) % AVERAGE_SIZE_SPEED;
+	}
+	b->resume = false;
+}
+
+static void batch_step(batch_t* b, uint32_t tick) {
+	batch_plant_sense(b);
+	batch_estimate(b);
+	if(CONTROL_TICK(tick)) {
+		batch_control(b);
+	}
+}
+
+/*
+ * sweep, comparison and report
+ */
+
+static double cpu_time(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static float env(const char* name, float value) {
+	const char* text = getenv(name);
+	return (text != NULL) ? atof(text) : value;
+}
+
+// robot i : slope and initial angle on a grid
+static void sweep(robot_param_t* param, uint32_t n) {
+	uint32_t angles = sqrtf(n) + 1;
+
+	for(uint32_t i = 0 ; i < n ; i++) {
+		float slope = SLOPE_MIN + (float)(SLOPE_MAX - SLOPE_MIN) * (i / angles) / ((n - 1) / angles + 1);
+		float angle = -180 + 360.f * (i % angles) / angles; // convention of slope_angle()
+
+		param[i].sin_incl = sinf(slope * DEG_TO_RAD);
+		param[i].cos_incl = cosf(slope * DEG_TO_RAD);
+		param[i].heading = (angle - 90) * DEG_TO_RAD;
+		param[i].seed = 2463534242u + i * 7919;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	uint32_t n = (argc > 1) ? atoi(argv[1]) : 4096;
+	uint32_t ticks = ((argc > 2) ? atof(argv[2]) : 30) * 1000 / TICK;
+	uint32_t check = (n < CHECK_ROBOTS) ? n : CHECK_ROBOTS;
+	robot_param_t* param = NULL;
+	robot_t* robots = NULL;
+	batch_t b;
+	double start = 0;
+	double scalar_s = 0;
+	double batch_s = 0;
+	uint64_t checked = 0;
+	uint64_t estimates = 0;
+	uint64_t commands = 0;
+	int32_t estimate_max = 0;
+	int32_t command_max = 0;
+	float position_max = 0;
+	uint32_t down_scalar = 0;
+	uint32_t down_batch = 0;
+
+	if(n == 0 || ticks == 0) {
+		fprintf(stderr, "usage : %s [robots] [simulated time [s]]\n", argv[0]);
+		return 1;
+	}
+	yaw_gain = env("SIM_YAW_GAIN", 1);
+	yaw_tau = env("SIM_YAW_TAU", 0);
+
+	param = malloc(n * sizeof(robot_param_t));
+	robots = malloc(n * sizeof(robot_t));
+	if(param == NULL || robots == NULL) {
+		fprintf(stderr, "not enough memory for %u robots\n", n);
+		return 1;
+	}
+	sweep(param, n);
+
+	// scalar version, one robot after the other
+	start = cpu_time();
+	for(uint32_t i = 0 ; i < n ; i++) {
+		robot_init(&robots[i], &param[i]);
+		for(uint32_t t = 0 ; t < ticks ; t++) {
+			robot_step(&robots[i], t);
+		}
+	}
+	scalar_s = cpu_time() - start;
+
+	// batch version, all the robots at each tick
+	batch_init(&b, param, n);
+	start = cpu_time();
+	for(uint32_t t = 0 ; t < ticks ; t++) {
+		batch_step(&b, t);
+	}
+	batch_s = cpu_time() - start;
+
+	for(uint32_t i = 0 ; i < n ; i++) {
+		float dx = robots[i].x - b.x[i];
+		float dy = robots[i].y - b.y[i];
+		float d = sqrtf(dx * dx + dy * dy);
+		position_max = (d > position_max) ? d : position_max;
+		down_scalar += robots[i].y < -RUNOUT;
+		down_batch += b.y[i] < -RUNOUT;
+	}
+	batch_free(&b);
+
+	// tick by tick on robots spread over the sweep, both versions in lockstep
+	for(uint32_t i = 0 ; i < check ; i++) {
+		param[i] = param[(uint64_t)i * n / check];
+		robot_init(&robots[i], &param[i]);
+	}
+	batch_init(&b, param, check);
+	for(uint32_t t = 0 ; t < ticks ; t++) {
+		batch_step(&b, t);
+		for(uint32_t i = 0 ; i < check ; i++) {
+			robot_t* r = &robots[i];
+			robot_step(r, t);
+			int32_t de = abs(heading_diff(r->estimate.angle, b.angle_mean[i]));
+			int32_t dc = abs(r->delta_mean - b.delta_mean[i]);
+			estimates += de != 0;
+			commands += dc != 0;
+			estimate_max = (de > estimate_max) ? de : estimate_max;
+			command_max = (dc > command_max) ? dc : command_max;
+			checked++;
+		}
+	}
+	batch_free(&b);
+
+	printf("%u robots, %u ticks of %u ms (%.0f s), slopes %d to %d deg, all the initial angles\n",
+			n, ticks, TICK, ticks * TICK / 1000.f, SLOPE_MIN, SLOPE_MAX);
+	printf("scalar        %.3g robot-ticks/s\n", (double)n * ticks / scalar_s);
+	printf("batch         %.3g robot-ticks/s (x%.2f), atan %s\n", (double)n * ticks / batch_s, scalar_s / batch_s,
+			BATCH_EXACT ? "of the C library" : "polynomial");
+	printf("estimates     %llu of %llu differ, max %.2f deg\n", (unsigned long long)estimates,
+			(unsigned long long)checked, (float)estimate_max / HEADING_SCALE);
+	printf("commands      %llu of %llu differ, max %d step/s\n", (unsigned long long)commands,
+			(unsigned long long)checked, command_max);
+	printf("positions     max difference %.2f mm at the end\n", position_max);
+	printf("descended     %u (scalar) %u (batch) of %u robots\n", down_scalar, down_batch, n);
+
+	free(param);
+	free(robots);
+
+	if(estimate_max > TOL_ESTIMATE || command_max > TOL_COMMAND || position_max > TOL_POSITION) {
+		printf("FAILED : the batch differs from the code of the firmware (tolerances %.2f deg, %d step/s, %.2f mm)\n",
+				(float)TOL_ESTIMATE / HEADING_SCALE, TOL_COMMAND, TOL_POSITION);
+		return 1;
+	}
+	return 0;
+}
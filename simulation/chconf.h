@@ -0,0 +1,18 @@
+/*
+ * chconf.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef SIM_CHCONF_H
+#define SIM_CHCONF_H
+
+// the simulation uses the kernel configuration of the firmware, with its hooks (trace, panic)
+#include "../miniprojet_SlopeFollower/chconf.h"
+
+// not supported by the SIMIA32 port
+#undef CH_DBG_ENABLE_STACK_CHECK
+#define CH_DBG_ENABLE_STACK_CHECK FALSE
+
+#endif /* SIM_CHCONF_H */
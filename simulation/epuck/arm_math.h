@@ -0,0 +1,13 @@
+/*
+ * arm_math.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef ARM_MATH_H_
+#define ARM_MATH_H_
+
+// included by the firmware but not used by the simulation : empty
+
+#endif /* ARM_MATH_H_ */
@@ -0,0 +1,13 @@
+/*
+ * microphone.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef MICROPHONE_H_
+#define MICROPHONE_H_
+
+// included by the firmware but not used by the simulation : empty
+
+#endif /* MICROPHONE_H_ */
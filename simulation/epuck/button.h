@@ -0,0 +1,17 @@
+/*
+ * button.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef BUTTON_H_
+#define BUTTON_H_
+
+// simulated button of the e-puck2 library (see sim_leds.c), same interface as the library
+
+#include <hal.h>
+
+bool button_is_pressed(void);
+
+#endif /* BUTTON_H_ */
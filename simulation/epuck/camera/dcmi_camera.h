@@ -0,0 +1,13 @@
+/*
+ * dcmi_camera.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef DCMI_CAMERA_H_
+#define DCMI_CAMERA_H_
+
+// included by the firmware but not used by the simulation : empty
+
+#endif /* DCMI_CAMERA_H_ */
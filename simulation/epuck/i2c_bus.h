@@ -0,0 +1,13 @@
+/*
+ * i2c_bus.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef I2C_BUS_H_
+#define I2C_BUS_H_
+
+// included by the firmware but not used by the simulation : empty
+
+#endif /* I2C_BUS_H_ */
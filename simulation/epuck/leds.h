@@ -0,0 +1,28 @@
+/*
+ * leds.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef LEDS_H_
+#define LEDS_H_
+
+// simulated LEDs of the e-puck2 library (see sim_leds.c), same interface as the library
+
+#include <hal.h>
+
+typedef enum {
+	LED1,
+	LED3,
+	LED5,
+	LED7,
+	NUM_LED,
+} led_name_t;
+
+void set_led(led_name_t led_number, unsigned int value);
+void clear_leds(void);
+void set_body_led(unsigned int value);
+void set_front_led(unsigned int value);
+
+#endif /* LEDS_H_ */
@@ -0,0 +1,13 @@
+/*
+ * memory_protection.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef MEMORY_PROTECTION_H_
+#define MEMORY_PROTECTION_H_
+
+// included by the firmware but not used by the simulation : empty
+
+#endif /* MEMORY_PROTECTION_H_ */
@@ -0,0 +1,25 @@
+/*
+ * motors.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef MOTORS_H_
+#define MOTORS_H_
+
+// simulated motors of the e-puck2 library (see sim_motors.c), same interface as the library
+
+#include <hal.h>
+
+#define MOTOR_SPEED_LIMIT 1100 // [step/s]
+
+void left_motor_set_speed(int speed);
+void right_motor_set_speed(int speed);
+int32_t left_motor_get_pos(void);
+int32_t right_motor_get_pos(void);
+void left_motor_set_pos(int32_t counter_value);
+void right_motor_set_pos(int32_t counter_value);
+void motors_init(void);
+
+#endif /* MOTORS_H_ */
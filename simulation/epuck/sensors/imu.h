@@ -0,0 +1,40 @@
+/*
+ * imu.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef IMU_H_
+#define IMU_H_
+
+// simulated IMU of the e-puck2 library (see sim_imu.c), same interface as the library
+// the samples are published on the "/imu" topic of the bus
+
+#include <hal.h>
+
+#define IMU_NB_AXIS 3
+
+typedef struct {
+	float acceleration[IMU_NB_AXIS];	// [m/s^2]
+	float gyro_rate[IMU_NB_AXIS];		// [rad/s]
+	float temperature;					// [deg C]
+	int16_t acc_raw[IMU_NB_AXIS];
+	int16_t gyro_raw[IMU_NB_AXIS];
+	int16_t acc_offset[IMU_NB_AXIS];
+	int16_t gyro_offset[IMU_NB_AXIS];
+	uint8_t status;
+} imu_msg_t;
+
+void imu_start(void);
+void calibrate_acc(void);
+int16_t get_acc(uint8_t axis);
+int16_t get_acc_offset(uint8_t axis);
+float get_acceleration(uint8_t axis);
+void calibrate_gyro(void);
+int16_t get_gyro(uint8_t axis);
+int16_t get_gyro_offset(uint8_t axis);
+float get_gyro_rate(uint8_t axis);
+float get_temperature(void);
+
+#endif /* IMU_H_ */
@@ -0,0 +1,13 @@
+/*
+ * mpu9250.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef MPU9250_H_
+#define MPU9250_H_
+
+// included by the firmware but not used by the simulation : empty
+
+#endif /* MPU9250_H_ */
@@ -0,0 +1,31 @@
+/*
+ * proximity.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef PROXIMITY_H_
+#define PROXIMITY_H_
+
+// simulated proximity sensors of the e-puck2 library (see sim_proximity.c), same interface as the library
+// the samples are published on the "/proximity" topic of the bus
+
+#include <hal.h>
+
+#define PROXIMITY_NB_CHANNELS 8
+
+typedef struct {
+	unsigned int ambient[PROXIMITY_NB_CHANNELS];
+	unsigned int reflected[PROXIMITY_NB_CHANNELS];
+	unsigned int delta[PROXIMITY_NB_CHANNELS];
+	unsigned int initValue[PROXIMITY_NB_CHANNELS];
+} proximity_msg_t;
+
+void proximity_start(void);
+void calibrate_ir(void);
+int get_prox(unsigned int sensor_number);
+int get_calibrated_prox(unsigned int sensor_number);
+int get_ambient_light(unsigned int sensor_number);
+
+#endif /* PROXIMITY_H_ */
@@ -0,0 +1,13 @@
+/*
+ * usbcfg.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef USBCFG_H_
+#define USBCFG_H_
+
+// included by the firmware but not used by the simulation : empty
+
+#endif /* USBCFG_H_ */
@@ -0,0 +1,34 @@
+/*
+ * halconf.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef HALCONF_H
+#define HALCONF_H
+
+// no driver of the HAL : the peripherals used by the firmware are simulated by the platform (platform/hal_lld.h)
+
+#define HAL_USE_PAL                 FALSE
+#define HAL_USE_ADC                 FALSE
+#define HAL_USE_CAN                 FALSE
+#define HAL_USE_DAC                 FALSE
+#define HAL_USE_EXT                 FALSE
+#define HAL_USE_GPT                 FALSE
+#define HAL_USE_I2C                 FALSE
+#define HAL_USE_I2S                 FALSE
+#define HAL_USE_ICU                 FALSE
+#define HAL_USE_MAC                 FALSE
+#define HAL_USE_MMC_SPI             FALSE
+#define HAL_USE_PWM                 FALSE
+#define HAL_USE_RTC                 FALSE
+#define HAL_USE_SDC                 FALSE
+#define HAL_USE_SERIAL              FALSE
+#define HAL_USE_SERIAL_USB          FALSE
+#define HAL_USE_SPI                 FALSE
+#define HAL_USE_UART                FALSE
+#define HAL_USE_USB                 FALSE
+#define HAL_USE_WDG                 FALSE
+
+#endif /* HALCONF_H */
@@ -0,0 +1,108 @@
+/*
+ * ch.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef HOST_CH_H
+#define HOST_CH_H
+
+/*
+ * Kernel of the host run (see host/kernel.c) : the part of the ChibiOS API used by the firmware and by the
+ * simulated drivers, on cooperative threads and a simulated time
+ * The critical zones are empty : a thread only gives the processor back when it waits
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <chconf.h>
+
+#if !defined(FALSE)
+#define FALSE 0
+#endif
+#if !defined(TRUE)
+#define TRUE 1
+#endif
+
+typedef uint32_t systime_t;
+typedef int32_t msg_t;
+typedef uint32_t tprio_t;
+typedef uint32_t eventmask_t;
+typedef uint32_t syssts_t;
+typedef uint64_t stkalign_t;
+typedef void (*tfunc_t)(void* arg);
+typedef struct host_thread thread_t;
+
+#define MSG_OK 0
+#define MSG_TIMEOUT -1
+#define MSG_RESET -2
+
+#define LOWPRIO 2
+#define NORMALPRIO 128
+#define HIGHPRIO 255
+
+#define ALL_EVENTS ((eventmask_t)-1)
+#define EVENT_MASK(eid) ((eventmask_t)1 << (eid))
+
+#define MS2ST(msec) ((systime_t)(((uint64_t)(msec) * CH_CFG_ST_FREQUENCY + 999) / 1000))
+#define US2ST(usec) ((systime_t)(((uint64_t)(usec) * CH_CFG_ST_FREQUENCY + 999999) / 1000000))
+#define ST2MS(n) ((uint32_t)(((uint64_t)(n) * 1000 + CH_CFG_ST_FREQUENCY - 1) / CH_CFG_ST_FREQUENCY))
+
+// the working area is kept for sizeof(), the threads of the host run have their own stack (HOST_STACK_SIZE)
+#define THD_WORKING_AREA(s, n) stkalign_t s[((n) + sizeof(stkalign_t) - 1) / sizeof(stkalign_t)]
+#define THD_FUNCTION(tname, arg) void tname(void* arg)
+
+#define chSysLock()
+#define chSysUnlock()
+#define chSysLockFromISR()
+#define chSysUnlockFromISR()
+#define chSysGetStatusAndLockX() ((syssts_t)0)
+#define chSysRestoreStatusX(sts) ((void)(sts))
+#define chDbgAssert(c, remark) do { if(!(c)) chSysHalt(remark); } while(0)
+
+// the mutex and the condition variables are only used by the bus (host/messagebus.c)
+typedef struct {
+	uint8_t unused;
+} mutex_t;
+
+typedef struct {
+	uint8_t unused;
+} condition_variable_t;
+
+#define MUTEX_DECL(name) mutex_t name = {0}
+#define CONDVAR_DECL(name) condition_variable_t name = {0}
+
+typedef struct {
+	bool taken;
+} binary_semaphore_t;
+
+#define BSEMAPHORE_DECL(name, taken) binary_semaphore_t name = {taken}
+
+void chSysInit(void);
+void chSysHalt(const char* reason);
+
+thread_t* chThdCreateStatic(void* wsp, size_t size, tprio_t prio, tfunc_t pf, void* arg);
+thread_t* chThdGetSelfX(void);
+msg_t chThdWait(thread_t* tp);
+void chThdSleep(systime_t time);
+void chThdSleepMilliseconds(uint32_t msec);
+void chThdSleepUntilWindowed(systime_t prev, systime_t next);
+void chRegSetThreadName(const char* name);
+
+systime_t chVTGetSystemTime(void);
+#define chVTGetSystemTimeX() chVTGetSystemTime()
+
+void chEvtSignal(thread_t* tp, eventmask_t events);
+eventmask_t chEvtWaitAny(eventmask_t events);
+
+void chBSemObjectInit(binary_semaphore_t* bsp, bool taken);
+msg_t chBSemWait(binary_semaphore_t* bsp);
+void chBSemSignal(binary_semaphore_t* bsp);
+
+// waits of the bus (host/messagebus.c) : the thread waits until the object is signaled
+void host_wait(const void* object);
+void host_signal(const void* object);
+
+#endif /* HOST_CH_H */
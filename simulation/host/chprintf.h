@@ -0,0 +1,19 @@
+/*
+ * chprintf.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef HOST_CHPRINTF_H
+#define HOST_CHPRINTF_H
+
+/*
+ * chprintf() of ChibiOS in the host run : the formats used by the firmware are the ones of the C library
+ */
+
+#include <hal.h>
+
+int chprintf(BaseSequentialStream* chp, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+#endif /* HOST_CHPRINTF_H */
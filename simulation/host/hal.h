@@ -0,0 +1,33 @@
+/*
+ * hal.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+/*
+ * Peripherals of the host run : the streams of ChibiOS and the platform of the simulation (platform/hal_lld.h)
+ */
+
+#include <ch.h>
+
+// sequential stream of ChibiOS (hal_streams.h), the serial port 3 is one (platform/sim_serial.c)
+struct BaseSequentialStreamVMT {
+	size_t (*write)(void* instance, const uint8_t* bp, size_t n);
+	size_t (*read)(void* instance, uint8_t* bp, size_t n);
+	msg_t (*put)(void* instance, uint8_t b);
+	msg_t (*get)(void* instance);
+};
+
+typedef struct {
+	const struct BaseSequentialStreamVMT* vmt;
+} BaseSequentialStream;
+
+#include <hal_lld.h>
+
+void halInit(void);
+
+#endif /* HOST_HAL_H */
@@ -0,0 +1,350 @@
+/*
+ * kernel.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include <ch.h>
+#include <hal.h>
+#include <chprintf.h>
+#include <stdarg.h>
+#include <plant.h>
+#include <trace.h>
+
+/*
+ * Host run : the firmware and the simulated drivers on a kernel written for the simulation, without ChibiOS
+ * (64 bit process, build with make host, run as the simulation : see plant.c for the configuration)
+ *
+ * The threads are cooperative (ucontext) and run on a simulated time of system ticks :
+ *   the highest priority thread ready runs until it waits (sleep, bus, event, semaphore, end of a thread),
+ *   a thread made ready with a higher priority than the running one runs first, as with the preemption,
+ *   the threads of the same priority run in the order they became ready
+ * When no thread is ready, the time advances by one tick : the interrupts of the timer 12 are served,
+ * the plant is stepped and the sleeps that end are made ready. The code takes no simulated time :
+ * the loads measured with the time base (busy time, release jitter) are the ones of a very fast processor.
+ * The run is deterministic : same configuration, same output.
+ *
+ * Not simulated : the round robin of the threads of same priority and the preemption in the middle of a
+ * computation, the stacks of the working areas (HOST_STACK_SIZE for each thread), the trace of the scheduler
+ * (trace.c needs the kernel of ChibiOS)
+ */
+
+#define HOST_STACK_SIZE (256 * 1024) // stack of each thread, the C library needs more than the working areas [byte]
+#define TICK_US (1000000 / CH_CFG_ST_FREQUENCY)
+#define TICK_MS (1000 / CH_CFG_ST_FREQUENCY)
+
+typedef enum {
+	TH_READY,
+	TH_CURRENT,
+	TH_SLEEPING,			// until wake
+	TH_WAIT_OBJECT,			// until host_signal(object) : bus, topic
+	TH_WAIT_EVENTS,			// until one of the events waited is signaled
+	TH_WAIT_SEM,			// until the semaphore object is signaled
+	TH_WAIT_EXIT,			// until the end of the thread object
+	TH_FINAL,
+} host_state_t;
+
+struct host_thread {
+	ucontext_t context;
+	const char* name;
+	tprio_t prio;
+	tfunc_t func;
+	void* arg;
+	host_state_t state;
+	int64_t order;				// position among the ready threads of the same priority
+	systime_t wake;				// end of the sleep [tick]
+	const void* object;			// object waited
+	eventmask_t events;			// events pending
+	eventmask_t waited;			// events waited
+	struct host_thread* next;	// all the threads, in the order of creation
+};
+
+static ucontext_t scheduler; // context of the scheduler, main() of the process
+static thread_t* threads = NULL;
+static thread_t* current = NULL; // running thread, NULL in the scheduler (system tick)
+static systime_t ticks = 0; // simulated time [tick]
+static int64_t back = 0; // order of the last thread made ready
+static int64_t front = 0; // order of the last thread preempted
+
+int firmware_main(void); // main() of the firmware, renamed by the Makefile
+
+/*
+ * scheduler
+ */
+
+static void make_ready(thread_t* tp, bool ahead) {
+	tp->state = TH_READY;
+	tp->order = ahead ? --front : ++back;
+}
+
+// highest priority thread ready, the first made ready among the ones of the same priority
+static thread_t* highest_ready(void) {
+	thread_t* best = NULL;
+
+	for(thread_t* tp = threads ; tp != NULL ; tp = tp->next) {
+		if(tp->state == TH_READY && (best == NULL || tp->prio > best->prio || (tp->prio == best->prio && tp->order < best->order))) {
+			best = tp;
+		}
+	}
+	return best;
+}
+
+// the running thread waits, the scheduler runs the next one
+static void block(host_state_t state) {
+	current->state = state;
+	swapcontext(&current->context, &scheduler);
+}
+
+// preemption : a thread of higher priority made ready by the running one runs first
+static void reschedule(void) {
+	thread_t* tp = highest_ready();
+
+	if(current != NULL && tp != NULL && tp->prio > current->prio) {
+		make_ready(current, true);
+		swapcontext(&current->context, &scheduler);
+	}
+}
+
+// system tick : timer 12, plant, end of the sleeps
+static void tick(void) {
+	ticks++;
+	sim_timer_serve();
+	plant_step(TICK_MS);
+
+	for(thread_t* tp = threads ; tp != NULL ; tp = tp->next) {
+		if(tp->state == TH_SLEEPING && (int32_t)(ticks - tp->wake) >= 0) {
+			make_ready(tp, false);
+		}
+	}
+}
+
+static void thread_start(void) {
+	current->func(current->arg);
+
+	// end of the thread
+	for(thread_t* tp = threads ; tp != NULL ; tp = tp->next) {
+		if(tp->state == TH_WAIT_EXIT && tp->object == current) {
+			make_ready(tp, false);
+		}
+	}
+	block(TH_FINAL);
+}
+
+static thread_t* thread_create(const char* name, tprio_t prio, tfunc_t pf, void* arg) {
+	thread_t* tp = calloc(1, sizeof(thread_t));
+	thread_t** last = &threads;
+
+	if(tp == NULL || getcontext(&tp->context) != 0) {
+		chSysHalt("no memory for a thread");
+	}
+	tp->context.uc_stack.ss_sp = malloc(HOST_STACK_SIZE);
+	tp->context.uc_stack.ss_size = HOST_STACK_SIZE;
+	tp->context.uc_link = NULL;
+	if(tp->context.uc_stack.ss_sp == NULL) {
+		chSysHalt("no memory for a stack");
+	}
+	makecontext(&tp->context, thread_start, 0);
+	tp->name = name;
+	tp->prio = prio;
+	tp->func = pf;
+	tp->arg = arg;
+
+	while(*last != NULL) {
+		last = &(*last)->next;
+	}
+	*last = tp;
+	make_ready(tp, false);
+	return tp;
+}
+
+static void main_thread(void* arg) {
+	(void)arg;
+	firmware_main();
+}
+
+int main(void) {
+	thread_create("main", NORMALPRIO, main_thread, NULL);
+
+	while(1) {
+		current = highest_ready();
+		if(current == NULL) {
+			tick(); // exits the process at the end of the simulation (plant_step())
+			continue;
+		}
+		current->state = TH_CURRENT;
+		swapcontext(&scheduler, &current->context);
+		current = NULL;
+	}
+}
+
+/*
+ * API of the kernel (ch.h)
+ */
+
+void halInit(void) {
+	sim_serial_init();
+	sim_flash_init();
+	plant_init();
+	printf("%s, host run\n", PLATFORM_NAME);
+}
+
+void chSysInit(void) {
+}
+
+void chSysHalt(const char* reason) {
+	fprintf(stderr, "panic : %s\n", reason);
+	exit(1);
+}
+
+thread_t* chThdCreateStatic(void* wsp, size_t size, tprio_t prio, tfunc_t pf, void* arg) {
+	thread_t* tp = NULL;
+
+	(void)wsp;
+	(void)size;
+	tp = thread_create(NULL, prio, pf, arg);
+	reschedule();
+	return tp;
+}
+
+thread_t* chThdGetSelfX(void) {
+	return current;
+}
+
+msg_t chThdWait(thread_t* tp) {
+	if(tp->state != TH_FINAL) {
+		current->object = tp;
+		block(TH_WAIT_EXIT);
+	}
+	return MSG_OK;
+}
+
+void chThdSleep(systime_t time) {
+	current->wake = ticks + time;
+	block(TH_SLEEPING);
+}
+
+void chThdSleepMilliseconds(uint32_t msec) {
+	chThdSleep(MS2ST(msec));
+}
+
+// sleeps until next if the time is still in [prev, next[, returns at once otherwise
+void chThdSleepUntilWindowed(systime_t prev, systime_t next) {
+	if((systime_t)(ticks - prev) < (systime_t)(next - prev)) {
+		chThdSleep(next - ticks);
+	}
+}
+
+void chRegSetThreadName(const char* name) {
+	current->name = name;
+}
+
+systime_t chVTGetSystemTime(void) {
+	return ticks;
+}
+
+void chEvtSignal(thread_t* tp, eventmask_t events) {
+	tp->events |= events;
+	if(tp->state == TH_WAIT_EVENTS && (tp->events & tp->waited)) {
+		make_ready(tp, false);
+		reschedule();
+	}
+}
+
+// the events waited that are pending are cleared and returned
+eventmask_t chEvtWaitAny(eventmask_t events) {
+	eventmask_t pending = 0;
+
+	if((current->events & events) == 0) {
+		current->waited = events;
+		block(TH_WAIT_EVENTS);
+	}
+	pending = current->events & events;
+	current->events &= ~pending;
+	return pending;
+}
+
+void chBSemObjectInit(binary_semaphore_t* bsp, bool taken) {
+	bsp->taken = taken;
+}
+
+msg_t chBSemWait(binary_semaphore_t* bsp) {
+	if(!bsp->taken) {
+		bsp->taken = true;
+		return MSG_OK;
+	}
+	current->object = bsp;
+	block(TH_WAIT_SEM);
+	return MSG_OK;
+}
+
+// the first thread waiting gets the semaphore, it stays taken
+void chBSemSignal(binary_semaphore_t* bsp) {
+	for(thread_t* tp = threads ; tp != NULL ; tp = tp->next) {
+		if(tp->state == TH_WAIT_SEM && tp->object == bsp) {
+			make_ready(tp, false);
+			reschedule();
+			return;
+		}
+	}
+	bsp->taken = false;
+}
+
+void host_wait(const void* object) {
+	current->object = object;
+	block(TH_WAIT_OBJECT);
+}
+
+// all the threads waiting for the object are made ready
+void host_signal(const void* object) {
+	for(thread_t* tp = threads ; tp != NULL ; tp = tp->next) {
+		if(tp->state == TH_WAIT_OBJECT && tp->object == object) {
+			make_ready(tp, false);
+		}
+	}
+	reschedule();
+}
+
+/*
+ * platform : time of the timer 12 (platform/sim_timer.c)
+ */
+uint64_t sim_time_us(void) {
+	return (uint64_t)ticks * TICK_US;
+}
+
+/*
+ * chprintf() of ChibiOS
+ */
+int chprintf(BaseSequentialStream* chp, const char* fmt, ...) {
+	char text[256];
+	va_list ap;
+	int n = 0;
+
+	va_start(ap, fmt);
+	n = vsnprintf(text, sizeof(text), fmt, ap);
+	va_end(ap);
+	if(n > (int)sizeof(text) - 1) {
+		n = sizeof(text) - 1;
+	}
+	chp->vmt->write(chp, (const uint8_t*)text, n);
+	return n;
+}
+
+/*
+ * trace.c of the firmware, without the kernel of ChibiOS
+ */
+void trace_switch(void* ntp, void* otp) {
+	(void)ntp;
+	(void)otp;
+}
+
+void trace_dump(BaseSequentialStream* out) {
+	(void)out;
+}
+
+void trace_stacks(BaseSequentialStream* out) {
+	chprintf(out, "\r\nstacks : not measured (host run)\r\n");
+}
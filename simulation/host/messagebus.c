@@ -0,0 +1,79 @@
+/*
+ * messagebus.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ch.h>
+#include <msgbus/messagebus.h>
+
+/*
+ * Bus of the e-puck2 library in the host run
+ * A topic keeps the last message published. messagebus_topic_wait() returns the next one : the threads waiting
+ * are woken by the publication, in the order of their priorities (host_signal() of host/kernel.c)
+ */
+
+void messagebus_init(messagebus_t* bus, void* lock, void* condvar) {
+	(void)lock;
+	(void)condvar;
+	bus->topics = NULL;
+}
+
+void messagebus_topic_init(messagebus_topic_t* topic, void* lock, void* condvar, void* buffer, size_t buffer_len) {
+	(void)lock;
+	(void)condvar;
+	memset(topic, 0, sizeof(messagebus_topic_t));
+	topic->buffer = buffer;
+	topic->buffer_len = buffer_len;
+}
+
+void messagebus_advertise_topic(messagebus_t* bus, messagebus_topic_t* topic, const char* name) {
+	topic->name = name;
+	topic->next = bus->topics;
+	bus->topics = topic;
+	host_signal(bus); // threads waiting for the topic in messagebus_find_topic_blocking()
+}
+
+messagebus_topic_t* messagebus_find_topic(messagebus_t* bus, const char* name) {
+	messagebus_topic_t* topic = bus->topics;
+
+	while(topic != NULL && strcmp(topic->name, name) != 0) {
+		topic = topic->next;
+	}
+	return topic;
+}
+
+messagebus_topic_t* messagebus_find_topic_blocking(messagebus_t* bus, const char* name) {
+	messagebus_topic_t* topic = messagebus_find_topic(bus, name);
+
+	while(topic == NULL) {
+		host_wait(bus);
+		topic = messagebus_find_topic(bus, name);
+	}
+	return topic;
+}
+
+void messagebus_topic_publish(messagebus_topic_t* topic, void* buf, size_t buf_len) {
+	memcpy(topic->buffer, buf, (buf_len < topic->buffer_len) ? buf_len : topic->buffer_len);
+	topic->published = true;
+	host_signal(topic);
+}
+
+/*
+ * \return	false if nothing has been published on the topic yet
+ */
+bool messagebus_topic_read(messagebus_topic_t* topic, void* buf, size_t buf_len) {
+	if(topic->published) {
+		memcpy(buf, topic->buffer, (buf_len < topic->buffer_len) ? buf_len : topic->buffer_len);
+	}
+	return topic->published;
+}
+
+void messagebus_topic_wait(messagebus_topic_t* topic, void* buf, size_t buf_len) {
+	host_wait(topic);
+	memcpy(buf, topic->buffer, (buf_len < topic->buffer_len) ? buf_len : topic->buffer_len);
+}
@@ -0,0 +1,39 @@
+/*
+ * messagebus.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef HOST_MESSAGEBUS_H
+#define HOST_MESSAGEBUS_H
+
+/*
+ * Bus of the e-puck2 library in the host run (see host/messagebus.c) : same interface, the waits are the ones
+ * of the kernel of the host run instead of a mutex and a condition variable
+ */
+
+#include <ch.h>
+
+typedef struct messagebus_topic_s {
+	void* buffer;						// last message published
+	size_t buffer_len;
+	bool published;						// true once a message has been published
+	const char* name;
+	struct messagebus_topic_s* next;	// next topic of the bus
+} messagebus_topic_t;
+
+typedef struct {
+	messagebus_topic_t* topics;			// topics advertised
+} messagebus_t;
+
+void messagebus_init(messagebus_t* bus, void* lock, void* condvar);
+void messagebus_topic_init(messagebus_topic_t* topic, void* lock, void* condvar, void* buffer, size_t buffer_len);
+void messagebus_advertise_topic(messagebus_t* bus, messagebus_topic_t* topic, const char* name);
+messagebus_topic_t* messagebus_find_topic(messagebus_t* bus, const char* name);
+messagebus_topic_t* messagebus_find_topic_blocking(messagebus_t* bus, const char* name);
+void messagebus_topic_publish(messagebus_topic_t* topic, void* buf, size_t buf_len);
+bool messagebus_topic_read(messagebus_topic_t* topic, void* buf, size_t buf_len);
+void messagebus_topic_wait(messagebus_topic_t* topic, void* buf, size_t buf_len);
+
+#endif /* HOST_MESSAGEBUS_H */
@@ -0,0 +1,17 @@
+/*
+ * parameter.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef HOST_PARAMETER_H
+#define HOST_PARAMETER_H
+
+// parameters of the e-puck2 library, declared by main.h but not used by the firmware : only the type in the host run
+
+typedef struct {
+	const char* id;
+} parameter_namespace_t;
+
+#endif /* HOST_PARAMETER_H */
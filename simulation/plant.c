@@ -0,0 +1,354 @@
+/*
+ * plant.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <plant.h>
+
+/*
+ * Model of the robot and of the arena for the simulation
+ * stepped by the system tick of the simulator (see platform/hal_lld.c), every ms of simulated time
+ *
+ * Arena : an inclined plane going down along -y, from the top wall (y = SIM_LENGTH) to y = 0,
+ * between two side walls, then a flat run-out. The simulation ends when the robot leaves the run-out.
+ * The robot is calibrated on a flat table : it is placed on the slope when the motors are started.
+ *
+ * Configuration (environment variables, all optional) :
+ *   SIM_SLOPE       inclination of the plane [deg] (20)
+ *   SIM_ANGLE       initial slope angle in the robot frame [deg], convention of slope_angle() (90)
+ *   SIM_X, SIM_Y    initial position [mm] (0, SIM_LENGTH - 150)
+ *   SIM_WIDTH       distance between the side walls [mm] (1000)
+ *   SIM_LENGTH      length of the slope [mm] (1500)
+ *   SIM_OBSTACLES   circular obstacles "x,y,radius;x,y,radius" [mm] (none)
+ *   SIM_NOISE       factor on the sensor noise, 0 for perfect sensors (1)
+ *   SIM_SEED        seed of the noise (1)
+ *   SIM_BUTTON      1 to hold the button at boot, so that the sensors are calibrated (0)
+ *   SIM_DURATION    simulated time after which the simulation ends [s] (120)
+ *   SIM_LOG         file where the state of the robot is written every 10 ms (none)
+ *   SIM_YAW_GAIN    factor on the rotation given by the speed difference of the wheels (slip) (1)
+ *   SIM_YAW_TAU     time constant of the rotation of the robot [ms] (0)
+ *   SIM_YAW_DELAY   dead time of the rotation of the robot [ms] (0)
+ * The three SIM_YAW values are the yaw model of a surface, fitted on recorded runs by tools/sysid.py
+ */
+
+#define PI_F 3.14159265f
+#define DEG_TO_RAD (PI_F / 180)
+
+// robot (e-puck2)
+#define STEP_MM 0.13f // wheel displacement for one step [mm]
+#define WHEEL_BASE 53.f // distance between the wheels [mm]
+#define ROBOT_RADIUS 37.f // [mm]
+#define IR_RADIUS 35.f // distance of the proximity sensors from the center [mm]
+
+// sensors
+#define ACC_1G 16384 // accelerometer [LSB/g], the Z axis points down
+#define GYRO_LSB_DPS 131.f // gyroscope [LSB/(deg/s)]
+#define IR_MAX 3800.f // proximity value against an obstacle
+#define IR_DECAY 9.f // distance for which the proximity value is divided by e [mm]
+#define IR_RANGE 100.f // distance above which the obstacles aren't seen [mm]
+#define IR_CONE (15 * DEG_TO_RAD) // half aperture of a sensor
+
+#define ACC_NOISE 40.f // standard deviation of the noise [LSB]
+#define GYRO_NOISE 15.f
+#define IR_NOISE 6.f
+
+#define RUNOUT 400.f // length of the flat surface after the slope [mm]
+#define LOG_PERIOD 10 // [ms]
+#define MAX_OBSTACLES 16
+#define MAX_DELAY 200 // [ms]
+
+// orientation of the proximity sensors, counterclockwise from the front (IR1 to IR8)
+static const float ir_angle[PLANT_NB_IR] = {-17, -49, -90, -150, 150, 90, 49, 17};
+// biases of the sensors, removed by the calibrations
+static const int16_t acc_bias[3] = {150, -90, 230};
+static const int16_t ir_offset[PLANT_NB_IR] = {45, 52, 59, 66, 73, 80, 87, 94};
+
+typedef struct {
+	float x;
+	float y;
+	float r;
+} obstacle_t;
+
+static plant_state_t st = {0};
+static float slope = 0; // [rad]
+static float width = 1000;
+static float length = 1500;
+static obstacle_t obstacles[MAX_OBSTACLES];
+static uint8_t nb_obstacles = 0;
+static float noise = 1;
+static unsigned int seed = 1;
+static bool button = false;
+static uint32_t duration = 120000; // [ms]
+static FILE* log_file = NULL;
+
+static int16_t left_speed = 0; // [step/s]
+static int16_t right_speed = 0;
+static float left_acc = 0; // fraction of step not counted yet
+static float right_acc = 0;
+static bool placed = false; // true when the robot is on the slope
+
+// yaw model : the steppers do the steps commanded, the robot body follows with slip, lag and dead time
+static float yaw_gain = 1;
+static float yaw_tau = 0; // [ms]
+static uint16_t yaw_delay = 0; // [ms]
+static float diff_delayed[MAX_DELAY] = {0}; // speed difference commanded in the last ms [step/s]
+static uint16_t delay_index = 0;
+static float diff_body = 0; // speed difference seen by the body [step/s]
+
+static float env(const char* name, float value) {
+	const char* text = getenv(name);
+	return (text != NULL) ? atof(text) : value;
+}
+
+/*
+ * gaussian noise (Box-Muller)
+ *
+ * \param sd	standard deviation
+ */
+static float gauss(float sd) {
+	float u1 = (rand_r(&seed) + 1.f) / (RAND_MAX + 2.f);
+	float u2 = (rand_r(&seed) + 1.f) / (RAND_MAX + 2.f);
+	return noise * sd * sqrtf(-2 * logf(u1)) * cosf(2 * PI_F * u2);
+}
+
+/*
+ * reads the configuration, places the robot on a flat table
+ */
+void plant_init(void) {
+	const char* text = getenv("SIM_OBSTACLES");
+	float angle = env("SIM_ANGLE", 90) * DEG_TO_RAD;
+
+	slope = env("SIM_SLOPE", 20) * DEG_TO_RAD;
+	width = env("SIM_WIDTH", 1000);
+	length = env("SIM_LENGTH", 1500);
+	noise = env("SIM_NOISE", 1);
+	seed = env("SIM_SEED", 1);
+	button = env("SIM_BUTTON", 0) != 0;
+	duration = env("SIM_DURATION", 120) * 1000;
+	yaw_gain = env("SIM_YAW_GAIN", 1);
+	yaw_tau = env("SIM_YAW_TAU", 0);
+	yaw_delay = env("SIM_YAW_DELAY", 0);
+	if(yaw_delay >= MAX_DELAY) {
+		yaw_delay = MAX_DELAY - 1;
+	}
+
+	st.x = env("SIM_X", 0);
+	st.y = env("SIM_Y", length - 150);
+	st.heading = angle - PI_F / 2; // the descent is at -90 deg in the arena
+
+	while(text != NULL && *text != '\0' && nb_obstacles < MAX_OBSTACLES) {
+		obstacle_t* o = &obstacles[nb_obstacles];
+		if(sscanf(text, "%f,%f,%f", &o->x, &o->y, &o->r) == 3) {
+			nb_obstacles++;
+		}
+		text = strchr(text, ';');
+		if(text != NULL) {
+			text++;
+		}
+	}
+
+	if(getenv("SIM_LOG") != NULL) {
+		log_file = fopen(getenv("SIM_LOG"), "w");
+		if(log_file != NULL) {
+			fprintf(log_file, "# time [ms] x [mm] y [mm] heading [deg] collisions\n");
+		}
+	}
+}
+
+/*
+ * true if the robot overlaps a wall or an obstacle at this position
+ */
+static bool collides(float x, float y) {
+	if(x - ROBOT_RADIUS < -width / 2 || x + ROBOT_RADIUS > width / 2 || y + ROBOT_RADIUS > length) {
+		return true;
+	}
+	for(uint8_t i = 0 ; i < nb_obstacles ; i++) {
+		float dx = x - obstacles[i].x;
+		float dy = y - obstacles[i].y;
+		if(dx * dx + dy * dy < (ROBOT_RADIUS + obstacles[i].r) * (ROBOT_RADIUS + obstacles[i].r)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * distance to the first wall or obstacle on a ray
+ *
+ * \return	distance [mm], IR_RANGE if there is nothing closer
+ */
+static float ray(float x, float y, float dir) {
+	float dx = cosf(dir);
+	float dy = sinf(dir);
+	float d = IR_RANGE;
+	float t = 0;
+
+	// walls
+	if(dx > 0) {
+		t = (width / 2 - x) / dx;
+		d = (t < d) ? t : d;
+	} else if(dx < 0) {
+		t = (-width / 2 - x) / dx;
+		d = (t < d) ? t : d;
+	}
+	if(dy > 0) {
+		t = (length - y) / dy;
+		d = (t < d) ? t : d;
+	}
+
+	// obstacles : intersection of the ray with the circle
+	for(uint8_t i = 0 ; i < nb_obstacles ; i++) {
+		float ox = obstacles[i].x - x;
+		float oy = obstacles[i].y - y;
+		float proj = ox * dx + oy * dy;
+		float dist2 = ox * ox + oy * oy - proj * proj;
+		float r2 = obstacles[i].r * obstacles[i].r;
+		if(proj > 0 && dist2 < r2) {
+			t = proj - sqrtf(r2 - dist2);
+			d = (t >= 0 && t < d) ? t : d;
+		}
+	}
+	return (d > 0) ? d : 0;
+}
+
+/*
+ * moves the robot during one period, with the speeds of the wheels
+ * the robot doesn't slide on the slope, it stops against the walls and the obstacles
+ *
+ * \param period	[ms]
+ */
+void plant_step(uint16_t period) {
+	float dt = period / 1000.f;
+	float left = left_speed * dt; // [step]
+	float right = right_speed * dt;
+	float distance = (left + right) / 2 * STEP_MM;
+	float diff = 0;
+	float x = 0;
+	float y = 0;
+
+	// speed difference seen by the body, delayed then filtered
+	diff_delayed[delay_index] = (left_speed - right_speed) / 2.f;
+	diff = diff_delayed[(delay_index + MAX_DELAY - yaw_delay) % MAX_DELAY];
+	delay_index = (delay_index + 1) % MAX_DELAY;
+	diff_body += (yaw_gain * diff - diff_body) * period / (yaw_tau + period);
+
+	left_acc += left;
+	right_acc += right;
+	st.left_pos += (int32_t)left_acc;
+	st.right_pos += (int32_t)right_acc;
+	left_acc -= (int32_t)left_acc;
+	right_acc -= (int32_t)right_acc;
+
+	st.yaw_rate = -2 * diff_body * STEP_MM / WHEEL_BASE;
+	st.heading += st.yaw_rate * dt;
+	x = st.x + distance * cosf(st.heading);
+	y = st.y + distance * sinf(st.heading);
+	if(collides(x, y)) {
+		st.collisions++;
+	} else {
+		st.x = x;
+		st.y = y;
+	}
+	st.time += period;
+
+	if(log_file != NULL && st.time % LOG_PERIOD == 0) {
+		fprintf(log_file, "%u %.1f %.1f %.1f %u\n", st.time, st.x, st.y, st.heading / DEG_TO_RAD, st.collisions);
+	}
+
+	if(st.y < -RUNOUT) {
+		printf("SIM END %u %.1f %.1f %u\n", st.time, st.x, st.y, st.collisions);
+		exit(0);
+	}
+	if(st.time >= duration) {
+		printf("SIM TIMEOUT %u %.1f %.1f %u\n", st.time, st.x, st.y, st.collisions);
+		exit(0);
+	}
+}
+
+/*
+ * speed command of the motors
+ * the first command places the robot on the slope
+ *
+ * \param left, right	[step/s]
+ */
+void plant_set_speed(int16_t left, int16_t right) {
+	left_speed = left;
+	right_speed = right;
+	placed = true;
+}
+
+void plant_set_pos(bool left, int32_t pos) {
+	if(left) {
+		st.left_pos = pos;
+	} else {
+		st.right_pos = pos;
+	}
+}
+
+void plant_get_state(plant_state_t* state) {
+	*state = st;
+}
+
+/*
+ * raw accelerations, with the convention of the IMU of the e-puck2
+ *
+ * \param acc	X, Y and Z values to fill [LSB]
+ */
+void plant_acc(int16_t* acc) {
+	float incl = (placed && st.y >= 0) ? slope : 0;
+	float angle = st.heading + PI_F / 2; // slope angle in the robot frame (positive on the right)
+
+	acc[0] = -ACC_1G * sinf(incl) * sinf(angle) + acc_bias[0] + gauss(ACC_NOISE);
+	acc[1] = -ACC_1G * sinf(incl) * cosf(angle) + acc_bias[1] + gauss(ACC_NOISE);
+	acc[2] = -ACC_1G * cosf(incl) + acc_bias[2] + gauss(ACC_NOISE);
+}
+
+/*
+ * raw yaw rate, the Z axis points down : positive when the robot turns clockwise
+ * saturated at the full scale (250 deg/s) as the MPU-9250 : the robot turns at 281 deg/s at full speed
+ */
+int16_t plant_gyro_z(void) {
+	float raw = -st.yaw_rate / DEG_TO_RAD * GYRO_LSB_DPS + gauss(GYRO_NOISE);
+
+	if(raw > INT16_MAX) {
+		return INT16_MAX;
+	} else if(raw < -INT16_MAX) {
+		return -INT16_MAX;
+	}
+	return raw;
+}
+
+float plant_temperature(void) {
+	return 30 + gauss(0.1f);
+}
+
+/*
+ * raw value of a proximity sensor (ambient and offset included)
+ * the closest surface seen in the cone of the sensor gives the reflected light
+ *
+ * \param sensor	0 to 7 (IR1 to IR8)
+ */
+int16_t plant_prox(uint8_t sensor) {
+	float dir = st.heading + ir_angle[sensor] * DEG_TO_RAD;
+	float x = st.x + IR_RADIUS * cosf(dir);
+	float y = st.y + IR_RADIUS * sinf(dir);
+	float d = ray(x, y, dir);
+	float signal = 0;
+
+	d = fminf(d, ray(x, y, dir - IR_CONE));
+	d = fminf(d, ray(x, y, dir + IR_CONE));
+	if(d < IR_RANGE) {
+		signal = IR_MAX * expf(-d / IR_DECAY);
+	}
+	return ir_offset[sensor] + signal + gauss(IR_NOISE);
+}
+
+bool plant_button(void) {
+	return button;
+}
@@ -0,0 +1,40 @@
+/*
+ * plant.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef PLANT_H_
+#define PLANT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PLANT_NB_IR 8
+
+// state of the simulated robot, in the frame of the arena
+// x to the right, y up the slope [mm], heading counterclockwise from the x axis [rad]
+typedef struct {
+	float x;
+	float y;
+	float heading;
+	float yaw_rate;					// counterclockwise [rad/s]
+	int32_t left_pos;				// wheel positions [step]
+	int32_t right_pos;
+	uint32_t time;					// simulated time [ms]
+	uint32_t collisions;			// periods spent against a wall or an obstacle
+} plant_state_t;
+
+void plant_init(void);
+void plant_step(uint16_t period);
+void plant_set_speed(int16_t left, int16_t right);
+void plant_set_pos(bool left, int32_t pos);
+void plant_get_state(plant_state_t* state);
+void plant_acc(int16_t* acc);
+int16_t plant_gyro_z(void);
+float plant_temperature(void);
+int16_t plant_prox(uint8_t sensor);
+bool plant_button(void);
+
+#endif /* PLANT_H_ */
@@ -0,0 +1,12 @@
+/*
+ * board.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <hal.h>
+
+// nothing to configure, the plant is initialized by hal_lld_init()
+void boardInit(void) {
+}
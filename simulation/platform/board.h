@@ -0,0 +1,21 @@
+/*
+ * board.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#define BOARD_NAME "e-puck2 simulation"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void boardInit(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOARD_H */
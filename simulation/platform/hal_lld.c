@@ -0,0 +1,114 @@
+/*
+ * hal_lld.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <hal.h>
+#include <plant.h>
+
+/*
+ * Time of the simulation
+ * The system tick is generated when the idle thread runs (SIMIA32 port) : the simulated time only advances
+ * when all the threads wait, as on the robot. Each tick steps the plant by one period.
+ * The flash (sim_flash.c), the timer 12 (sim_timer.c) and the serial port (sim_serial.c) are shared with the host run
+ *
+ * SIM_WARP (environment) : speed of the simulated time compared to the real time
+ *   1 : real time (default), 10 : ten times faster, 0 : as fast as possible
+ */
+
+#define TICK_US (1000000 / CH_CFG_ST_FREQUENCY) // period of the system tick in simulated time [us]
+#define TICK_MS (1000 / CH_CFG_ST_FREQUENCY)
+
+static float warp = 1;
+static uint64_t tick_real_ns = 0; // real duration of a tick [ns], 0 as fast as possible
+static uint64_t next_tick = 0; // real time of the next tick [ns]
+static uint64_t last_tick = 0; // real time of the last tick [ns]
+static uint32_t ticks = 0; // simulated time [tick]
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*
+ * simulated time [us]
+ * between two ticks, the real time elapsed (multiplied by the warp) gives the microseconds
+ */
+uint64_t sim_time_us(void) {
+	uint64_t us = (now_ns() - last_tick) / 1000;
+
+	if(warp != 0) {
+		us *= warp;
+	}
+	if(us >= TICK_US) {
+		us = TICK_US - 1;
+	}
+	return (uint64_t)ticks * TICK_US + us;
+}
+
+void st_lld_init(void) {
+}
+
+void hal_lld_init(void) {
+	const char* text = getenv("SIM_WARP");
+
+	if(text != NULL) {
+		warp = atof(text);
+	}
+	tick_real_ns = (warp > 0) ? TICK_US * 1000 / warp : 0;
+
+	sim_serial_init();
+	sim_flash_init();
+	plant_init();
+
+	printf("%s, time warp %g\n", PLATFORM_NAME, warp);
+	last_tick = now_ns();
+	next_tick = last_tick + tick_real_ns;
+}
+
+/*
+ * called by the idle thread (port_wait_for_interrupt() of the SIMIA32 port)
+ * generates the system tick when its real time is reached, and steps the plant
+ */
+void _sim_check_for_interrupts(void) {
+	uint64_t now = now_ns();
+
+	if(now < next_tick) {
+		return;
+	}
+	last_tick = now;
+	next_tick += tick_real_ns;
+	if(next_tick < now) {
+		next_tick = now; // the simulation is late : the time warp can't be reached
+	}
+	ticks++;
+
+	CH_IRQ_PROLOGUE();
+	sim_timer_serve(); // interrupt of timer 12, for each overflow since the last tick
+	chSysLockFromISR();
+	plant_step(TICK_MS);
+	chSysTimerHandlerI();
+	chSysUnlockFromISR();
+	CH_IRQ_EPILOGUE();
+
+	_dbg_check_lock();
+	if(chSchIsPreemptionRequired()) {
+		chSchDoReschedule();
+	}
+	_dbg_check_unlock();
+}
+
+/*
+ * called by CH_CFG_SYSTEM_HALT_HOOK (chconf.h)
+ */
+void panic_handler(const char* reason) {
+	fprintf(stderr, "panic : %s\n", reason);
+	exit(1);
+}
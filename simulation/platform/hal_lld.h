@@ -0,0 +1,119 @@
+/*
+ * hal_lld.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef HAL_LLD_H
+#define HAL_LLD_H
+
+/*
+ * Platform of the simulation (Linux process, SIMIA32 port of ChibiOS, or kernel of the host run)
+ * Only the peripherals used directly by the firmware are simulated :
+ *   the timer 12 (1 MHz, 16 bit) and its overflow interrupt, used by the time base (timebase.c)
+ *   the serial port 3, written on the standard output
+ *   the flash controller and the calibration sector (see calibration.c), kept in a file between two runs
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PLATFORM_NAME "e-puck2 simulation (Linux)"
+#define HAL_IMPLEMENTS_COUNTERS FALSE
+
+// timer 12
+typedef uint32_t gptfreq_t;
+typedef uint16_t gptcnt_t;
+typedef struct GPTDriver GPTDriver;
+typedef void (*gptcallback_t)(GPTDriver* gptp);
+
+typedef struct {
+	gptfreq_t frequency;
+	gptcallback_t callback;
+	uint32_t cr2;
+	uint32_t dier;
+} GPTConfig;
+
+struct GPTDriver {
+	const GPTConfig* config;
+	uint16_t interval;		// the counter goes from 0 to interval - 1, 0 when stopped
+};
+
+extern GPTDriver GPTD12;
+
+#define gptStart(gptp, cfg) ((gptp)->config = (cfg))
+#define gptStartContinuous(gptp, value) ((gptp)->interval = (value))
+#define gptGetCounterX(gptp) sim_timer_counter()
+#define gptIsWrapPendingX(gptp) sim_timer_wrap_pending()
+
+// serial port 3 : a BaseSequentialStream writing on the standard output
+struct BaseSequentialStreamVMT;
+
+typedef struct {
+	uint32_t speed;
+	uint32_t cr1;
+	uint32_t cr2;
+	uint32_t cr3;
+} SerialConfig;
+
+typedef struct {
+	const struct BaseSequentialStreamVMT* vmt;
+} SerialDriver;
+
+extern SerialDriver SD3;
+
+#define sdStart(sdp, cfg) ((void)(sdp), (void)(cfg))
+
+// flash controller, the pending operation is done at the next access to the registers
+typedef struct {
+	volatile uint32_t ACR;
+	volatile uint32_t KEYR;
+	volatile uint32_t OPTKEYR;
+	volatile uint32_t SR;
+	volatile uint32_t CR;
+	volatile uint32_t OPTCR;
+} FLASH_TypeDef;
+
+#define FLASH (sim_flash_regs())
+
+#define FLASH_ACR_DCEN		(1u << 10)
+#define FLASH_ACR_DCRST		(1u << 12)
+#define FLASH_SR_EOP		(1u << 0)
+#define FLASH_SR_OPERR		(1u << 1)
+#define FLASH_SR_WRPERR		(1u << 4)
+#define FLASH_SR_PGAERR		(1u << 5)
+#define FLASH_SR_PGPERR		(1u << 6)
+#define FLASH_SR_PGSERR		(1u << 7)
+#define FLASH_SR_BSY		(1u << 16)
+#define FLASH_CR_PG			(1u << 0)
+#define FLASH_CR_SER		(1u << 1)
+#define FLASH_CR_PSIZE_1	(1u << 9)
+#define FLASH_CR_STRT		(1u << 16)
+#define FLASH_CR_LOCK		(1u << 31)
+
+// sectors 8 to 11 of the flash : black box (8 to 10) and calibration (11)
+#define SIM_FLASH_SECTOR_SIZE 0x20000
+#define SIM_FLASH_FIRST_SECTOR 8
+#define SIM_FLASH_NB_SECTORS 4
+extern uint32_t sim_flash_sector[SIM_FLASH_NB_SECTORS * SIM_FLASH_SECTOR_SIZE / sizeof(uint32_t)];
+#define BLACKBOX_ADDRESS ((uintptr_t)sim_flash_sector) // 32 bit in the SIMIA32 port, 64 bit in the host run
+#define CALIB_ADDRESS ((uintptr_t)sim_flash_sector + (11 - SIM_FLASH_FIRST_SECTOR) * SIM_FLASH_SECTOR_SIZE)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void hal_lld_init(void);
+void _sim_check_for_interrupts(void);
+uint64_t sim_time_us(void);
+uint16_t sim_timer_counter(void);
+bool sim_timer_wrap_pending(void);
+void sim_timer_serve(void);
+void sim_flash_init(void);
+FLASH_TypeDef* sim_flash_regs(void);
+void sim_serial_init(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_LLD_H */
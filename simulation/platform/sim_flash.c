@@ -0,0 +1,81 @@
+/*
+ * sim_flash.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <hal.h>
+
+/*
+ * Flash controller of the simulation : the sectors 8 to 11 (black box and calibration) are kept in memory,
+ * loaded from SIM_FLASH at the start and written back at the end of the process
+ * SIM_FLASH (environment) : file keeping the sectors between two runs (sim_flash.bin),
+ *   the sectors 8 to 11 one after the other : tools/blackbox.py decodes it
+ * Shared by the kernel simulation (hal_lld.c) and the host run (host/kernel.c)
+ */
+
+uint32_t sim_flash_sector[SIM_FLASH_NB_SECTORS * SIM_FLASH_SECTOR_SIZE / sizeof(uint32_t)];
+
+static FLASH_TypeDef flash_regs = {0};
+static const char* flash_file = "sim_flash.bin";
+
+static void flash_save(void) {
+	FILE* f = fopen(flash_file, "wb");
+
+	if(f != NULL) {
+		fwrite(sim_flash_sector, 1, sizeof(sim_flash_sector), f);
+		fclose(f);
+	}
+}
+
+/*
+ * loads the sectors (erased if the file doesn't exist), they are written back when the process exits
+ */
+void sim_flash_init(void) {
+	FILE* f = NULL;
+
+	if(getenv("SIM_FLASH") != NULL) {
+		flash_file = getenv("SIM_FLASH");
+	}
+
+	f = fopen(flash_file, "rb");
+	memset(sim_flash_sector, 0xFF, sizeof(sim_flash_sector));
+	if(f != NULL) {
+		if(fread(sim_flash_sector, 1, sizeof(sim_flash_sector), f) != sizeof(sim_flash_sector)) {
+			memset(sim_flash_sector, 0xFF, sizeof(sim_flash_sector));
+		}
+		fclose(f);
+	}
+	flash_regs.CR = FLASH_CR_LOCK;
+	flash_regs.ACR = FLASH_ACR_DCEN;
+	atexit(flash_save);
+}
+
+/*
+ * registers of the flash controller
+ * the operations are immediate : the erase asked by the last write of CR is done here
+ * the number of the sector is in the bits 3 to 6 of CR
+ * the data cache of the ART accelerator isn't simulated : the reads always see the sectors
+ */
+FLASH_TypeDef* sim_flash_regs(void) {
+	uint32_t sector = 0;
+
+	if(flash_regs.KEYR == 0xCDEF89AB) {
+		flash_regs.CR &= ~FLASH_CR_LOCK;
+		flash_regs.KEYR = 0;
+	}
+	if((flash_regs.CR & FLASH_CR_STRT) && (flash_regs.CR & FLASH_CR_SER)) {
+		sector = (flash_regs.CR >> 3) & 0xF;
+		if(sector >= SIM_FLASH_FIRST_SECTOR && sector < SIM_FLASH_FIRST_SECTOR + SIM_FLASH_NB_SECTORS) {
+			memset((uint8_t*)sim_flash_sector + (sector - SIM_FLASH_FIRST_SECTOR) * SIM_FLASH_SECTOR_SIZE, 0xFF, SIM_FLASH_SECTOR_SIZE);
+		} else {
+			flash_regs.SR |= FLASH_SR_WRPERR; // the other sectors hold the program
+		}
+		flash_regs.CR &= ~FLASH_CR_STRT;
+	}
+	return &flash_regs;
+}
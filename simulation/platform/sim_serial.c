@@ -0,0 +1,46 @@
+/*
+ * sim_serial.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <hal.h>
+
+/*
+ * Serial port 3 of the simulation, written on the standard output
+ * Shared by the kernel simulation (hal_lld.c) and the host run (host/kernel.c)
+ */
+
+SerialDriver SD3;
+
+static size_t sd_write(void* instance, const uint8_t* bp, size_t n) {
+	(void)instance;
+	n = fwrite(bp, 1, n, stdout);
+	fflush(stdout);
+	return n;
+}
+
+static size_t sd_read(void* instance, uint8_t* bp, size_t n) {
+	(void)instance;
+	(void)bp;
+	(void)n;
+	return 0;
+}
+
+static msg_t sd_put(void* instance, uint8_t b) {
+	return sd_write(instance, &b, 1) == 1 ? MSG_OK : MSG_RESET;
+}
+
+static msg_t sd_get(void* instance) {
+	(void)instance;
+	return MSG_RESET;
+}
+
+static const struct BaseSequentialStreamVMT sd_vmt = {sd_write, sd_read, sd_put, sd_get};
+
+void sim_serial_init(void) {
+	SD3.vmt = &sd_vmt;
+}
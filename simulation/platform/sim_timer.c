@@ -0,0 +1,52 @@
+/*
+ * sim_timer.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <hal.h>
+
+/*
+ * Timer 12 of the simulation (1 MHz, 16 bit), used by the time base (timebase.c)
+ * The counter is the simulated time given by the platform (sim_time_us()) modulo the interval of
+ * gptStartContinuous(), as the hardware. Its overflow interrupt is served by sim_timer_serve(), at each system tick.
+ * Shared by the kernel simulation (hal_lld.c) and the host run (host/kernel.c)
+ */
+
+GPTDriver GPTD12;
+
+static uint64_t timer_wraps = 0; // overflows of timer 12 served by its interrupt
+
+static uint16_t timer_interval(void) {
+	return (GPTD12.interval != 0) ? GPTD12.interval : 0xFFFF;
+}
+
+/*
+ * counter of timer 12 : simulated time [us] modulo the interval
+ */
+uint16_t sim_timer_counter(void) {
+	return sim_time_us() % timer_interval();
+}
+
+/*
+ * update flag of timer 12 : an overflow happened and its interrupt hasn't been served yet
+ */
+bool sim_timer_wrap_pending(void) {
+	return sim_time_us() / timer_interval() > timer_wraps;
+}
+
+/*
+ * interrupt of timer 12, called for each overflow since the last call
+ * to call from the interrupt context of the platform (system tick)
+ */
+void sim_timer_serve(void) {
+	while(GPTD12.interval != 0 && sim_time_us() / GPTD12.interval > timer_wraps) {
+		timer_wraps++;
+		if(GPTD12.config != NULL && GPTD12.config->callback != NULL) {
+			GPTD12.config->callback(&GPTD12);
+		}
+	}
+}
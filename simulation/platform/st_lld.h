@@ -0,0 +1,23 @@
+/*
+ * st_lld.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef ST_LLD_H
+#define ST_LLD_H
+
+// the periodic system tick is generated by _sim_check_for_interrupts() (see hal_lld.c)
+
+#define ST_LLD_NUM_ALARMS 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void st_lld_init(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ST_LLD_H */
@@ -0,0 +1,124 @@
+/*
+ * prox_replay.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <prox.h>
+#include <sensors/proximity.h>
+#include <executive.h>
+#include <calibration.h>
+
+/*
+ * Replay of IR logs through the proximity acquisition of the firmware (prox_task() of prox.c), without the kernel
+ *
+ * The log is the serial output of the robot with PROX_LOG (prox.c) : each line of 6 values is one period of
+ * the proximity thread, the calibrated values of IR3, IR2, IR1, IR8, IR7 and IR6. The other lines are ignored.
+ * Each sample is given to prox_task() as the sensors would : the filter, the hysteresis and the confirmation
+ * of prox.c are the ones of the firmware. The values are already calibrated : the ambient stored is 0.
+ *
+ * usage : prox_replay < log, built with make replay (tools/prox_replay.py builds the variants of prox.c)
+ * Printed, one line per sample : alert of a single raw sample (compute_prox_alert() without filter),
+ * alert given to the regulator, confidence [%]
+ */
+
+static int16_t sample[PROXIMITY_NB_CHANNELS] = {0}; // raw values of the current line, by sensor number
+
+/*
+ * doubles of the drivers and of the modules used by prox.c
+ */
+
+int get_prox(unsigned int sensor_number) {
+	return sample[sensor_number];
+}
+
+int16_t get_ir_calibration(uint8_t sensor) {
+	(void)sensor;
+	return 0;
+}
+
+void calibrate_ir(void) {
+}
+
+void calibration_store_ir(void) {
+}
+
+void release_update(uint8_t task, uint16_t period) {
+	(void)task;
+	(void)period;
+}
+
+/*
+ * doubles of the kernel : prox_task() is called by the replay, the thread of prox.c isn't started
+ */
+
+void chSysHalt(const char* reason) {
+	fprintf(stderr, "panic : %s\n", reason);
+	exit(1);
+}
+
+thread_t* chThdCreateStatic(void* wsp, size_t size, tprio_t prio, tfunc_t pf, void* arg) {
+	(void)wsp;
+	(void)size;
+	(void)prio;
+	(void)pf;
+	(void)arg;
+	chSysHalt("no thread in the replay");
+	return NULL;
+}
+
+void chThdSleepMilliseconds(uint32_t msec) {
+	(void)msec;
+}
+
+void chThdSleepUntilWindowed(systime_t prev, systime_t next) {
+	(void)prev;
+	(void)next;
+}
+
+void chRegSetThreadName(const char* name) {
+	(void)name;
+}
+
+systime_t chVTGetSystemTime(void) {
+	return 0;
+}
+
+msg_t chBSemWait(binary_semaphore_t* bsp) {
+	bsp->taken = true;
+	return MSG_OK;
+}
+
+void chBSemSignal(binary_semaphore_t* bsp) {
+	bsp->taken = false;
+}
+
+int main(void) {
+	char line[256];
+	int v[NB_PROX_SENSORS];
+	uint32_t samples = 0;
+
+	while(fgets(line, sizeof(line), stdin) != NULL) {
+		if(sscanf(line, "%d %d %d %d %d %d", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != NB_PROX_SENSORS) {
+			continue;
+		}
+		// order of the log : IR3, IR2, IR1, IR8, IR7, IR6 (sensors 2, 1, 0, 7, 6, 5)
+		sample[2] = v[0];
+		sample[1] = v[1];
+		sample[0] = v[2];
+		sample[7] = v[3];
+		sample[6] = v[4];
+		sample[5] = v[5];
+
+		prox_task();
+		printf("%d %d %u\n", compute_prox_alert(v[0], v[1], v[2], v[3], v[4], v[5]), get_prox_alert(), get_prox_confidence());
+		samples++;
+	}
+	fprintf(stderr, "%u samples\n", samples);
+	return 0;
+}
@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+"""
+scenarios.py
+
+Runs the control scenarios on the simulation of the firmware and compares the scores with a baseline.
+
+usage : scenarios.py [-j jobs] [-k scenario] [--update] [--sim build/slopefollower_host]
+
+Each scenario is a configuration of the plant (see plant.c). The runs are independent processes,
+as fast as possible (SIM_WARP=0), with a fixed seed : a scenario always gives the same scores
+for the same firmware. They are run in parallel.
+
+Scores of a run (from the state of the robot written by the plant every 10 ms) :
+	align [ms]       time from the start of the motors until the heading error stays under ALIGNED for ALIGN_HOLD
+	overshoot [deg]  biggest error on the other side of the descent after the first crossing, the side
+	                 of the approach is the one of the first error under 90 deg
+	error [deg]      RMS heading error on the slope once aligned (steady state)
+	descent [mm/s]   speed of descent on the slope
+	escapes, escape [ms] from the performance sent by the firmware at the end of the run (see odometry.c)
+	collisions [ms]  time spent against a wall or an obstacle
+A score worse than its baseline by more than TOLERANCE (and by more than its absolute noise floor) is a regression.
+The baseline (scenarios_baseline.json) is written with --update, to commit with the firmware.
+It comes from the host run (make host) : the simulation on ChibiOS (--sim build/slopefollower_sim) takes
+the time of the computations into account and needs its own baseline.
+A scenario without baseline fails : the comparison can't be done.
+"""
+
+import argparse
+import concurrent.futures
+import json
+import math
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+BASELINE = os.path.join(HERE, "scenarios_baseline.json")
+
+ALIGNED = 5.0 # heading error under which the robot is aligned [deg]
+ALIGN_HOLD = 500 # time under ALIGNED to be aligned [ms]
+DESCENT = -90.0 # direction of the descent in the arena [deg]
+TOLERANCE = 0.10 # relative degradation accepted
+
+# for each score : True if bigger is better, absolute noise floor
+SCORES = {
+	"align":		(False, 50),
+	"overshoot":	(False, 1.0),
+	"error":		(False, 0.2),
+	"descent":		(True, 2.0),
+	"escapes":		(False, 0),
+	"escape":		(False, 100),
+	"collisions":	(False, 20),
+}
+
+# obstacles forming a wall across the descent, 300 mm under the start
+WALL_DOWNHILL = ";".join("%d,1050,40" % x for x in range(-240, 241, 80))
+FIELD = "-150,1000,30;120,850,40;-60,650,35;200,500,30;-220,350,40;40,250,30"
+# two staggered walls : the robot meets each wall again after its escapes unless it goes around it (map.c)
+COURSE = WALL_DOWNHILL + ";" + ";".join("%d,600,40" % x for x in range(-60, 421, 80))
+
+SCENARIOS = {
+	"slope_10":			{"SIM_SLOPE": 10},
+	"slope_15":			{"SIM_SLOPE": 15},
+	"slope_20":			{"SIM_SLOPE": 20},
+	"slope_30":			{"SIM_SLOPE": 30},
+	"near_limit_11":	{"SIM_SLOPE": 11},
+	"near_limit_12":	{"SIM_SLOPE": 12},
+	"flip_180":			{"SIM_SLOPE": 20, "SIM_ANGLE": 180},
+	"flip_-179":		{"SIM_SLOPE": 20, "SIM_ANGLE": -179},
+	"aligned":			{"SIM_SLOPE": 20, "SIM_ANGLE": 0},
+	"obstacle_field":	{"SIM_SLOPE": 20, "SIM_ANGLE": 0, "SIM_OBSTACLES": FIELD},
+	# the walls take about 100 s to go around : the run must end for the firmware to send its escapes
+	"wall_downhill":	{"SIM_SLOPE": 20, "SIM_ANGLE": 0, "SIM_OBSTACLES": WALL_DOWNHILL, "SIM_DURATION": 150},
+	"obstacle_course":	{"SIM_SLOPE": 20, "SIM_ANGLE": 0, "SIM_OBSTACLES": COURSE, "SIM_DURATION": 150},
+}
+
+COMMON = {"SIM_WARP": 0, "SIM_SEED": 1, "SIM_BUTTON": 1, "SIM_DURATION": 90}
+
+
+def wrap(angle):
+	"""angle in ]-180, 180] [deg]"""
+	return (angle + 180) % 360 - 180
+
+
+def scores(log, output):
+	"""scores of a run from the plant log and the standard output of the simulation"""
+	samples = []
+	with open(log) as f:
+		for line in f:
+			if line.startswith("#"):
+				continue
+			t, x, y, heading, collisions = line.split()
+			samples.append((int(t), float(x), float(y), wrap(float(heading) - DESCENT), int(collisions)))
+	result = {}
+
+	# start : the first movement of the robot
+	start = next((i for i in range(1, len(samples)) if samples[i][1:3] != samples[0][1:3]), None)
+	if start is None:
+		return {"status": "did not move"}
+	slope = [s for s in samples[start:] if s[2] >= 0]
+	t0 = samples[start][0]
+
+	# alignment
+	aligned = None
+	since = None
+	for t, x, y, err, c in slope:
+		if abs(err) < ALIGNED:
+			since = t if since is None else since
+			if t - since >= ALIGN_HOLD:
+				aligned = since
+				break
+		else:
+			since = None
+	result["align"] = (aligned - t0) if aligned is not None else None
+
+	# overshoot : on the other side of the descent than the approach (first error under 90 deg,
+	# the sign of an error near 180 deg only depends on the noise)
+	approach = next((i for i in range(len(slope)) if abs(slope[i][3]) < 90), 0)
+	first = slope[approach][3] if slope else 0
+	crossed = False
+	overshoot = 0.0
+	for t, x, y, err, c in slope[approach:]:
+		if not crossed and err * first <= 0:
+			crossed = True
+		if crossed and err * first < 0:
+			overshoot = max(overshoot, abs(err))
+		if aligned is not None and t > aligned + 5000:
+			break
+	result["overshoot"] = round(overshoot, 2)
+
+	# steady state and descent speed
+	steady = [s[3] for s in slope if aligned is not None and s[0] >= aligned]
+	result["error"] = round(math.sqrt(sum(e * e for e in steady) / len(steady)), 2) if steady else None
+	if len(slope) > 1 and slope[-1][0] > slope[0][0]:
+		result["descent"] = round((slope[0][2] - slope[-1][2]) * 1000 / (slope[-1][0] - slope[0][0]), 1)
+	else:
+		result["descent"] = None
+	result["collisions"] = samples[-1][4]
+
+	# performance sent by the firmware
+	m = re.findall(r"escapes\s+(\d+)", output)
+	result["escapes"] = int(m[-1]) if m else None
+	m = re.findall(r"time lost per escape\s+(\d+)", output)
+	result["escape"] = int(m[-1]) if m else (0 if result["escapes"] == 0 else None)
+
+	result["status"] = "end" if "SIM END" in output else "timeout"
+	return result
+
+
+def run(sim, name, config):
+	"""runs one scenario in its own folder (flash file, log)"""
+	with tempfile.TemporaryDirectory() as tmp:
+		env = dict(os.environ)
+		env.update({k: str(v) for k, v in COMMON.items()})
+		env.update({k: str(v) for k, v in config.items()})
+		env["SIM_LOG"] = os.path.join(tmp, "plant.log")
+		env["SIM_FLASH"] = os.path.join(tmp, "flash.bin")
+		try:
+			proc = subprocess.run([sim], env=env, cwd=tmp, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+								  universal_newlines=True, errors="replace", timeout=600)
+		except subprocess.TimeoutExpired:
+			return name, {"status": "hung"}
+		if proc.returncode != 0:
+			return name, {"status": "failed (%d)" % proc.returncode}
+		return name, scores(env["SIM_LOG"], proc.stdout)
+
+
+def compare(name, result, base):
+	"""regressions of a scenario compared with its baseline"""
+	regressions = []
+	if base is None:
+		return regressions
+	if result.get("status") != base.get("status"):
+		regressions.append("status %s (was %s)" % (result.get("status"), base.get("status")))
+	for score, (bigger, floor) in SCORES.items():
+		new, old = result.get(score), base.get(score)
+		if old is None:
+			continue
+		if new is None:
+			regressions.append("%s missing" % score)
+			continue
+		delta = (old - new) if bigger else (new - old)
+		if delta > floor and delta > TOLERANCE * abs(old):
+			regressions.append("%s %s (was %s)" % (score, new, old))
+	return regressions
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.split("\n")[3])
+	parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count())
+	parser.add_argument("-k", "--only", action="append", help="scenario to run (all by default)")
+	parser.add_argument("--update", action="store_true", help="writes the results as the new baseline")
+	parser.add_argument("--sim", default=os.path.join(HERE, "build", "slopefollower_host"))
+	args = parser.parse_args()
+
+	if not os.path.exists(args.sim):
+		sys.exit("%s not found : build the simulation first (make host in simulation/)" % args.sim)
+	names = args.only or list(SCENARIOS)
+	for name in names:
+		if name not in SCENARIOS:
+			sys.exit("unknown scenario %s" % name)
+
+	results = {}
+	with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+		for name, result in pool.map(lambda n: run(os.path.abspath(args.sim), n, SCENARIOS[n]), names):
+			results[name] = result
+
+	baseline = {}
+	if os.path.exists(BASELINE):
+		with open(BASELINE) as f:
+			baseline = json.load(f)
+
+	columns = ["align", "overshoot", "error", "descent", "escapes", "escape", "collisions"]
+	print("%-16s %-8s" % ("scenario", "status") + "".join("%11s" % c for c in columns))
+	failed = 0
+	missing = 0
+	for name in names:
+		result = results[name]
+		cells = "".join("%11s" % ("-" if result.get(c) is None else result[c]) for c in columns)
+		print("%-16s %-8s%s" % (name, result.get("status"), cells))
+		regressions = compare(name, result, baseline.get(name))
+		if name not in baseline:
+			print("    NO BASELINE")
+			missing += 1
+		for r in regressions:
+			print("    REGRESSION %s" % r)
+		failed += len(regressions) != 0
+
+	if args.update:
+		baseline.update(results)
+		with open(BASELINE, "w") as f:
+			json.dump(baseline, f, indent=1, sort_keys=True)
+		print("baseline written to %s" % BASELINE)
+	elif failed or missing:
+		print("%d scenario(s) with regressions, %d without baseline" % (failed, missing))
+		if missing:
+			print("run with --update to write the baseline %s" % BASELINE)
+		sys.exit(1)
+	else:
+		print("no regression")
+
+
+if __name__ == "__main__":
+	main()
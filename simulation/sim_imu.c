@@ -0,0 +1,122 @@
+/*
+ * sim_imu.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <main.h>
+#include <sensors/imu.h>
+#include <plant.h>
+
+/*
+ * Simulated IMU : a thread samples the plant and publishes on the "/imu" topic, as the library does
+ */
+
+#define IMU_PERIOD 4 // [ms], 250 Hz as the library
+#define CALIBRATION_SAMPLES 50
+
+#define ACC_1G 16384 // [LSB/g]
+#define STANDARD_GRAVITY 9.80665f
+#define GYRO_RAD_PER_LSB (3.14159265f / 180 / 131)
+#define Z_AXIS 2
+
+static imu_msg_t imu_values = {0};
+static imu_msg_t imu_topic_value; // buffer of the topic
+
+static messagebus_topic_t imu_topic;
+static MUTEX_DECL(imu_topic_lock);
+static CONDVAR_DECL(imu_topic_condvar);
+
+static THD_WORKING_AREA(imu_reader_thd_wa, 1024);
+static THD_FUNCTION(imu_reader_thd, arg) {
+
+	chRegSetThreadName(__FUNCTION__);
+	(void)arg;
+
+	systime_t time;
+
+	while(1) {
+		time = chVTGetSystemTime();
+
+		chSysLock();
+		plant_acc(imu_values.acc_raw);
+		imu_values.gyro_raw[Z_AXIS] = plant_gyro_z();
+		imu_values.temperature = plant_temperature();
+		chSysUnlock();
+
+		for(uint8_t i = 0 ; i < IMU_NB_AXIS ; i++) {
+			imu_values.acceleration[i] = (float)(imu_values.acc_raw[i] - imu_values.acc_offset[i]) * STANDARD_GRAVITY / ACC_1G;
+			imu_values.gyro_rate[i] = (imu_values.gyro_raw[i] - imu_values.gyro_offset[i]) * GYRO_RAD_PER_LSB;
+		}
+
+		messagebus_topic_publish(&imu_topic, &imu_values, sizeof(imu_values));
+
+		chThdSleepUntilWindowed(time, time + MS2ST(IMU_PERIOD));
+	}
+}
+
+void imu_start(void) {
+	messagebus_topic_init(&imu_topic, &imu_topic_lock, &imu_topic_condvar, &imu_topic_value, sizeof(imu_topic_value));
+	messagebus_advertise_topic(&bus, &imu_topic, "/imu");
+
+	chThdCreateStatic(imu_reader_thd_wa, sizeof(imu_reader_thd_wa), NORMALPRIO, imu_reader_thd, NULL);
+}
+
+/*
+ * mean of the next samples, the robot must not move
+ */
+static void mean_samples(bool gyro, int16_t* mean) {
+	imu_msg_t msg;
+	int32_t sum[IMU_NB_AXIS] = {0};
+
+	for(uint8_t n = 0 ; n < CALIBRATION_SAMPLES ; n++) {
+		messagebus_topic_wait(&imu_topic, &msg, sizeof(msg));
+		for(uint8_t i = 0 ; i < IMU_NB_AXIS ; i++) {
+			sum[i] += gyro ? msg.gyro_raw[i] : msg.acc_raw[i];
+		}
+	}
+	for(uint8_t i = 0 ; i < IMU_NB_AXIS ; i++) {
+		mean[i] = sum[i] / CALIBRATION_SAMPLES;
+	}
+}
+
+void calibrate_acc(void) {
+	mean_samples(false, imu_values.acc_offset);
+}
+
+void calibrate_gyro(void) {
+	mean_samples(true, imu_values.gyro_offset);
+}
+
+int16_t get_acc(uint8_t axis) {
+	return imu_values.acc_raw[axis];
+}
+
+int16_t get_acc_offset(uint8_t axis) {
+	return imu_values.acc_offset[axis];
+}
+
+float get_acceleration(uint8_t axis) {
+	return imu_values.acceleration[axis];
+}
+
+int16_t get_gyro(uint8_t axis) {
+	return imu_values.gyro_raw[axis];
+}
+
+int16_t get_gyro_offset(uint8_t axis) {
+	return imu_values.gyro_offset[axis];
+}
+
+float get_gyro_rate(uint8_t axis) {
+	return imu_values.gyro_rate[axis];
+}
+
+float get_temperature(void) {
+	return imu_values.temperature;
+}
@@ -0,0 +1,47 @@
+/*
+ * sim_leds.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <leds.h>
+#include <button.h>
+#include <plant.h>
+
+/*
+ * Simulated LEDs and button
+ * the state of the LEDs is only kept, the button is given by the plant (SIM_BUTTON)
+ */
+
+static unsigned int leds[NUM_LED] = {0};
+static unsigned int body_led = 0;
+static unsigned int front_led = 0;
+
+void set_led(led_name_t led_number, unsigned int value) {
+	if(led_number < NUM_LED) {
+		leds[led_number] = value;
+	}
+}
+
+void clear_leds(void) {
+	for(uint8_t i = 0 ; i < NUM_LED ; i++) {
+		leds[i] = 0;
+	}
+}
+
+void set_body_led(unsigned int value) {
+	body_led = value;
+}
+
+void set_front_led(unsigned int value) {
+	front_led = value;
+}
+
+bool button_is_pressed(void) {
+	return plant_button();
+}
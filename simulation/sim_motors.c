@@ -0,0 +1,69 @@
+/*
+ * sim_motors.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <motors.h>
+#include <plant.h>
+
+/*
+ * Simulated stepper motors : the speeds are given to the plant, which counts the steps
+ * as in the library, there is no critical zone here : drive_update() writes both motors in its own one
+ * (with the SIMIA32 port, the plant is only stepped when the idle thread runs)
+ */
+
+static int16_t left_speed = 0; // [step/s]
+static int16_t right_speed = 0;
+
+static int16_t limit(int speed) {
+	if(speed > MOTOR_SPEED_LIMIT) {
+		return MOTOR_SPEED_LIMIT;
+	} else if(speed < -MOTOR_SPEED_LIMIT) {
+		return -MOTOR_SPEED_LIMIT;
+	}
+	return speed;
+}
+
+void left_motor_set_speed(int speed) {
+	left_speed = limit(speed);
+	plant_set_speed(left_speed, right_speed);
+}
+
+void right_motor_set_speed(int speed) {
+	right_speed = limit(speed);
+	plant_set_speed(left_speed, right_speed);
+}
+
+int32_t left_motor_get_pos(void) {
+	plant_state_t st;
+	plant_get_state(&st);
+	return st.left_pos;
+}
+
+int32_t right_motor_get_pos(void) {
+	plant_state_t st;
+	plant_get_state(&st);
+	return st.right_pos;
+}
+
+void left_motor_set_pos(int32_t counter_value) {
+	plant_set_pos(true, counter_value);
+}
+
+void right_motor_set_pos(int32_t counter_value) {
+	plant_set_pos(false, counter_value);
+}
+
+/*
+ * the robot is placed on the slope when the motors are started
+ */
+void motors_init(void) {
+	left_motor_set_speed(0);
+	right_motor_set_speed(0);
+}
@@ -0,0 +1,89 @@
+/*
+ * sim_proximity.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <main.h>
+#include <sensors/proximity.h>
+#include <plant.h>
+
+/*
+ * Simulated proximity sensors : a thread samples the plant and publishes on the "/proximity" topic, as the library does
+ * the plant gives the raw value (ambient and offset included) : it is the delta of the library
+ */
+
+#define PROXIMITY_PERIOD 10 // [ms], 100 Hz as the library
+#define CALIBRATION_SAMPLES 100
+
+static proximity_msg_t prox_values = {0};
+static proximity_msg_t proximity_topic_value; // buffer of the topic
+
+static messagebus_topic_t proximity_topic;
+static MUTEX_DECL(proximity_topic_lock);
+static CONDVAR_DECL(proximity_topic_condvar);
+
+static THD_WORKING_AREA(proximity_thd_wa, 1024);
+static THD_FUNCTION(proximity_thd, arg) {
+
+	chRegSetThreadName(__FUNCTION__);
+	(void)arg;
+
+	systime_t time;
+
+	while(1) {
+		time = chVTGetSystemTime();
+
+		chSysLock();
+		for(uint8_t i = 0 ; i < PROXIMITY_NB_CHANNELS ; i++) {
+			prox_values.delta[i] = plant_prox(i);
+		}
+		chSysUnlock();
+
+		messagebus_topic_publish(&proximity_topic, &prox_values, sizeof(prox_values));
+
+		chThdSleepUntilWindowed(time, time + MS2ST(PROXIMITY_PERIOD));
+	}
+}
+
+void proximity_start(void) {
+	messagebus_topic_init(&proximity_topic, &proximity_topic_lock, &proximity_topic_condvar, &proximity_topic_value, sizeof(proximity_topic_value));
+	messagebus_advertise_topic(&bus, &proximity_topic, "/proximity");
+
+	chThdCreateStatic(proximity_thd_wa, sizeof(proximity_thd_wa), NORMALPRIO, proximity_thd, NULL);
+}
+
+/*
+ * mean of the next samples, the robot must be far from the obstacles
+ */
+void calibrate_ir(void) {
+	proximity_msg_t msg;
+	uint32_t sum[PROXIMITY_NB_CHANNELS] = {0};
+
+	for(uint8_t n = 0 ; n < CALIBRATION_SAMPLES ; n++) {
+		messagebus_topic_wait(&proximity_topic, &msg, sizeof(msg));
+		for(uint8_t i = 0 ; i < PROXIMITY_NB_CHANNELS ; i++) {
+			sum[i] += msg.delta[i];
+		}
+	}
+	for(uint8_t i = 0 ; i < PROXIMITY_NB_CHANNELS ; i++) {
+		prox_values.initValue[i] = sum[i] / CALIBRATION_SAMPLES;
+	}
+}
+
+int get_prox(unsigned int sensor_number) {
+	return prox_values.delta[sensor_number];
+}
+
+int get_calibrated_prox(unsigned int sensor_number) {
+	return (int)prox_values.delta[sensor_number] - (int)prox_values.initValue[sensor_number];
+}
+
+int get_ambient_light(unsigned int sensor_number) {
+	return prox_values.ambient[sensor_number];
+}
@@ -0,0 +1,28 @@
+/*
+ * ch.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef TESTS_CH_H
+#define TESTS_CH_H
+
+/*
+ * Kernel of the host tests : only the critical zones used by the tested modules
+ * The interrupts are served by the test (test_timebase.c) when the zone ends, the other tests have no interrupt
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint32_t syssts_t;
+
+syssts_t chSysGetStatusAndLockX(void);
+void chSysRestoreStatusX(syssts_t status);
+void chSysLockFromISR(void);
+void chSysUnlockFromISR(void);
+void chSysLock(void);
+void chSysUnlock(void);
+
+#endif /* TESTS_CH_H */
@@ -0,0 +1,19 @@
+/*
+ * chprintf.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef TESTS_CHPRINTF_H
+#define TESTS_CHPRINTF_H
+
+/*
+ * Formatted output of the host tests, defined by the test that prints a module (test_map.c)
+ */
+
+#include <hal.h>
+
+int chprintf(BaseSequentialStream* chp, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+#endif /* TESTS_CHPRINTF_H */
@@ -0,0 +1,47 @@
+/*
+ * hal.h
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#ifndef TESTS_HAL_H
+#define TESTS_HAL_H
+
+/*
+ * Peripherals of the host tests : the timer 12 of the time base, driven by the test (test_timebase.c)
+ * Same interface as the platform of the simulation (platform/hal_lld.h)
+ * The streams are written by chprintf() of the test (test_map.c)
+ */
+
+#include <ch.h>
+
+typedef uint32_t gptfreq_t;
+typedef struct GPTDriver GPTDriver;
+typedef void (*gptcallback_t)(GPTDriver* gptp);
+
+typedef struct {
+	gptfreq_t frequency;
+	gptcallback_t callback;
+	uint32_t cr2;
+	uint32_t dier;
+} GPTConfig;
+
+struct GPTDriver {
+	const GPTConfig* config;
+	uint16_t interval;		// the counter goes from 0 to interval - 1
+};
+
+extern GPTDriver GPTD12;
+
+typedef struct BaseSequentialStream BaseSequentialStream;
+
+#define gptStart(gptp, cfg) ((gptp)->config = (cfg))
+#define gptStartContinuous(gptp, value) ((gptp)->interval = (value))
+#define gptGetCounterX(gptp) test_timer_counter()
+#define gptIsWrapPendingX(gptp) test_timer_wrap_pending()
+
+uint16_t test_timer_counter(void);
+bool test_timer_wrap_pending(void);
+
+#endif /* TESTS_HAL_H */
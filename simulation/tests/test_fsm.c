@@ -0,0 +1,166 @@
+/*
+ * test_fsm.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fsm.h>
+
+/*
+ * Host test of the state machine (fsm.c) with the structure of the movement states of regulation.c :
+ * drive encloses slope and flat, escape has a timeout and a guarded end, the obstacle is handled by drive.
+ * The actions write their name in a trace, each step is compared with the expected actions.
+ *
+ * usage : test_fsm, returns 1 if a step differs
+ */
+
+#define ST_TOP FSM_TOP
+#define ST_DRIVE 1
+#define ST_SLOPE 2
+#define ST_FLAT 3
+#define ST_ESCAPE 4
+#define NB_STATES 5
+
+#define EV_TIMEOUT FSM_TIMEOUT
+#define EV_OBSTACLE 1
+#define EV_FLAT 2
+#define EV_SLOPE 3
+#define EV_PERIOD 4
+#define EV_IGNORED 5	// handled by no state
+#define NB_EVENTS 6
+
+#define ESCAPE_TIMEOUT 2000 // [ms]
+
+static char trace[256] = ""; // actions of the step
+static bool obstacle_ahead = true; // guard of the escape
+static bool rotation_done = false; // guard of the end of the escape
+static uint32_t errors = 0;
+
+static void record(const char* action) {
+	strncat(trace, trace[0] == '\0' ? "" : " ", sizeof(trace) - strlen(trace) - 1);
+	strncat(trace, action, sizeof(trace) - strlen(trace) - 1);
+}
+
+static void drive_entry(void) { record("+drive"); }
+static void drive_exit(void) { record("-drive"); }
+static void slope_entry(void) { record("+slope"); }
+static void slope_exit(void) { record("-slope"); }
+static void slope_run(void) { record("slope"); }
+static void flat_entry(void) { record("+flat"); }
+static void flat_exit(void) { record("-flat"); }
+static void flat_run(void) { record("flat"); }
+static void escape_entry(void) { record("+escape"); }
+static void escape_exit(void) { record("-escape"); }
+static void escape_action(void) { record("turn"); }
+static bool escape_needed(void) { return obstacle_ahead; }
+static bool escape_done(void) { return rotation_done; }
+
+static const fsm_state_t states[NB_STATES] = {
+	// name			parent		entry			exit			run			timeout [ms]
+	{"top",			ST_TOP,		NULL,			NULL,			NULL,		0},
+	{"drive",		ST_TOP,		drive_entry,	drive_exit,		NULL,		0},
+	{"slope",		ST_DRIVE,	slope_entry,	slope_exit,		slope_run,	0},
+	{"flat",		ST_DRIVE,	flat_entry,		flat_exit,		flat_run,	0},
+	{"escape",		ST_TOP,		escape_entry,	escape_exit,	NULL,		ESCAPE_TIMEOUT},
+};
+
+static const fsm_transition_t table[NB_STATES][NB_EVENTS] = {
+	[ST_DRIVE] = {
+		[EV_OBSTACLE] =		{ST_ESCAPE,	escape_needed,	escape_action},
+	},
+	[ST_SLOPE] = {
+		[EV_FLAT] =			{ST_FLAT,	NULL,			NULL},
+	},
+	[ST_FLAT] = {
+		[EV_SLOPE] =		{ST_SLOPE,	NULL,			NULL},
+		[EV_FLAT] =			{ST_FLAT,	NULL,			NULL},	// transition to itself : exit and entry again
+	},
+	[ST_ESCAPE] = {
+		[EV_TIMEOUT] =		{ST_SLOPE,	NULL,			NULL},
+		[EV_PERIOD] =		{ST_SLOPE,	escape_done,	NULL},
+	},
+};
+
+/*
+ * one step, compared with the expected actions and state
+ */
+static void step(fsm_t* fsm, const char* name, uint32_t events, uint32_t now, const char* actions, uint8_t state) {
+	uint8_t current = 0;
+
+	trace[0] = '\0';
+	current = fsm_step(fsm, events, now);
+	if(strcmp(trace, actions) != 0 || current != state) {
+		printf("%s : actions \"%s\" in %s, expected \"%s\" in %s\n", name, trace, states[current].name, actions,
+				states[state].name);
+		errors++;
+	}
+}
+
+static void expect(const char* name, bool value) {
+	if(!value) {
+		printf("%s : false\n", name);
+		errors++;
+	}
+}
+
+int main(void) {
+	fsm_t fsm;
+	fsm_log_t entry;
+
+	// entry of the nested initial state, from the outermost
+	fsm_init(&fsm, states, NB_STATES, &table[0][0], NB_EVENTS, ST_FLAT, 0);
+	expect("init : +drive +flat", strcmp(trace, "+drive +flat") == 0);
+	expect("init : in flat and drive", fsm_in(&fsm, ST_FLAT) && fsm_in(&fsm, ST_DRIVE) && fsm_in(&fsm, ST_TOP));
+	expect("init : not in escape", !fsm_in(&fsm, ST_ESCAPE));
+
+	// ignored events : no transition, only the run action
+	step(&fsm, "no event", 0, 10, "flat", ST_FLAT);
+	step(&fsm, "ignored", FSM_EVENT(EV_IGNORED) | FSM_EVENT(EV_PERIOD), 20, "flat", ST_FLAT);
+
+	// between two children of drive : drive stays active
+	step(&fsm, "flat -> slope", FSM_EVENT(EV_SLOPE), 30, "-flat +slope slope", ST_SLOPE);
+	step(&fsm, "flat in slope", FSM_EVENT(EV_FLAT), 40, "-slope +flat flat", ST_FLAT);
+	step(&fsm, "flat to itself", FSM_EVENT(EV_FLAT), 50, "-flat +flat flat", ST_FLAT);
+
+	// event handled by the parent, guard false then true : exits up to the common ancestor, action, entry
+	obstacle_ahead = false;
+	step(&fsm, "obstacle, guard false", FSM_EVENT(EV_OBSTACLE), 60, "flat", ST_FLAT);
+	obstacle_ahead = true;
+	step(&fsm, "obstacle", FSM_EVENT(EV_OBSTACLE) | FSM_EVENT(EV_SLOPE), 100, "-flat -drive turn +escape", ST_ESCAPE);
+
+	// priority : obstacle (1) before slope (3), at most one transition per step ; escape has no run action
+	step(&fsm, "escape, not done", FSM_EVENT(EV_PERIOD) | FSM_EVENT(EV_SLOPE), 200, "", ST_ESCAPE);
+	rotation_done = true;
+	step(&fsm, "escape done", FSM_EVENT(EV_PERIOD), 300, "-escape +drive +slope slope", ST_SLOPE);
+
+	// timeout : raised after ESCAPE_TIMEOUT in the state, first priority
+	rotation_done = false;
+	step(&fsm, "obstacle again", FSM_EVENT(EV_OBSTACLE), 1000, "-slope -drive turn +escape", ST_ESCAPE);
+	step(&fsm, "before timeout", FSM_EVENT(EV_PERIOD), 1000 + ESCAPE_TIMEOUT - 1, "", ST_ESCAPE);
+	step(&fsm, "timeout", FSM_EVENT(EV_PERIOD), 1000 + ESCAPE_TIMEOUT, "-escape +drive +slope slope", ST_SLOPE);
+
+	// log : transitions in order, with the time and the event
+	expect("transitions", fsm.transitions == 7);
+	expect("log oldest", fsm_get_log(&fsm, 0, &entry) && entry.from == ST_FLAT && entry.to == ST_SLOPE
+			&& entry.event == EV_SLOPE && entry.time == 30);
+	expect("log last", fsm_get_log(&fsm, 6, &entry) && entry.from == ST_ESCAPE && entry.to == ST_SLOPE
+			&& entry.event == EV_TIMEOUT && entry.time == 1000 + ESCAPE_TIMEOUT);
+	expect("log end", !fsm_get_log(&fsm, 7, &entry));
+
+	// the log keeps the last FSM_LOG_SIZE transitions
+	for(uint8_t i = 0 ; i < FSM_LOG_SIZE ; i++) {
+		step(&fsm, "flat", FSM_EVENT(EV_FLAT), 4000 + 20 * i, "-slope +flat flat", ST_FLAT);
+		step(&fsm, "slope", FSM_EVENT(EV_SLOPE), 4010 + 20 * i, "-flat +slope slope", ST_SLOPE);
+	}
+	expect("log full", fsm_get_log(&fsm, FSM_LOG_SIZE - 1, &entry) && entry.to == ST_SLOPE
+			&& !fsm_get_log(&fsm, FSM_LOG_SIZE, &entry));
+	expect("log oldest kept", fsm_get_log(&fsm, 0, &entry) && entry.from == ST_SLOPE && entry.to == ST_FLAT
+			&& entry.time == 4000 + 20 * (FSM_LOG_SIZE / 2));
+
+	printf("test_fsm : %u transitions, %u errors\n", fsm.transitions, errors);
+	return errors != 0;
+}
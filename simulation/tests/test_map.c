@@ -0,0 +1,205 @@
+/*
+ * test_map.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <ch.h>
+#include <hal.h>
+#include <chprintf.h>
+#include <prox.h>
+#include <odometry.h>
+#include <map.h>
+
+/*
+ * Host test of the map (map.c) with a straight wall across the descent
+ * The robot model moves in the frame of the odometry (x along the descent, y to the left). The proximity alert
+ * gives the closest point of the wall in front of the robot, closer than SENSE_RANGE, as prox.c does (bearing
+ * and range).
+ * The robot meets the wall and moves along it as the escape maneuvers do, then it backs up and descends again
+ * following the route of the map at once : the map alone has to bring it around the wall already met.
+ * Then the robot sweeps more cells than the map holds : the obstacles must be kept.
+ *
+ * usage : test_map, returns 1 if a check fails
+ */
+
+#define WALL_X 300 // distance of the wall along the descent [mm]
+#define WALL_HALF 150 // half length of the wall, centered on the path [mm]
+#define ROBOT_RADIUS 37 // [mm]
+#define SENSE_RANGE 100 // farthest obstacle seen by the proximity sensors, from the center [mm]
+#define WALL_STEP 1.f // distance moved at each regulation period [mm] (100 mm/s at 10 ms)
+#define WALL_GAP 20 // distance between the robot and the wall when it moves along it [mm]
+#define BACK_UP 250 // distance of the robot from the wall before the second descent [mm]
+#define MAX_PERIODS 5000 // the robot must pass the wall before
+#define SWEEP_CELLS 400 // cells visited by the sweep, more than the map holds
+#define MAP_CELL 60 // side of a cell of map.c [mm]
+
+#define PI 3.14159f
+#define DEG_TO_RAD (PI / 180)
+
+static float x = 0; // position of the robot [mm]
+static float y = 0;
+static heading_t heading = 0; // direction of the robot in the frame of the map [heading]
+static bool flat = false;
+static uint32_t collisions = 0; // periods where the robot couldn't move
+static uint32_t errors = 0;
+
+/*
+ * doubles of the modules read by the map
+ */
+
+heading_t get_angle(void) {
+	return heading;
+}
+
+bool get_slope(void) {
+	return flat;
+}
+
+int16_t get_inclination(void) {
+	return 500;
+}
+
+void get_odometry_stats(odometry_stats_t* run) {
+	run->descent = x;
+	run->lateral = y;
+	run->ended = false;
+}
+
+// closest point of the wall, with its range [mm] and its bearing from the front of the robot [rad]
+static void closest(float* range, float* bearing) {
+	float wy = (y > WALL_HALF) ? WALL_HALF : ((y < -WALL_HALF) ? -WALL_HALF : y);
+
+	*range = sqrtf((WALL_X - x) * (WALL_X - x) + (wy - y) * (wy - y));
+	*bearing = atan2f(wy - y, WALL_X - x) - heading * DEG_TO_RAD / HEADING_SCALE;
+	*bearing = atan2f(sinf(*bearing), cosf(*bearing));
+}
+
+int8_t get_prox_alert(void) {
+	float range = 0;
+	float bearing = 0;
+
+	closest(&range, &bearing);
+	return (range < SENSE_RANGE && fabsf(bearing) < PI / 2) ? 1 : 0;
+}
+
+void get_prox_obstacle(prox_obstacle_t* obstacle) {
+	float range = 0;
+	float bearing = 0;
+
+	closest(&range, &bearing);
+	obstacle->range = (range < SENSE_RANGE && fabsf(bearing) < PI / 2) ? range : PROX_RANGE_NONE;
+	obstacle->bearing = bearing / DEG_TO_RAD * HEADING_SCALE;
+}
+
+void chSysLock(void) {
+}
+
+void chSysUnlock(void) {
+}
+
+int chprintf(BaseSequentialStream* chp, const char* fmt, ...) {
+	va_list ap;
+	int n = 0;
+
+	(void)chp;
+	va_start(ap, fmt);
+	n = vprintf(fmt, ap);
+	va_end(ap);
+	return n;
+}
+
+/*
+ * model of the robot : one regulation period
+ */
+static void period(void) {
+	float nx = 0;
+	float ny = 0;
+
+	map_update(false);
+	heading = map_route();
+	nx = x + WALL_STEP * cosf(heading * DEG_TO_RAD / HEADING_SCALE);
+	ny = y + WALL_STEP * sinf(heading * DEG_TO_RAD / HEADING_SCALE);
+
+	if(x < WALL_X && nx > WALL_X - ROBOT_RADIUS && fabsf(ny) < WALL_HALF + ROBOT_RADIUS) {
+		collisions++;
+		return;
+	}
+	x = nx;
+	y = ny;
+}
+
+static void expect(const char* name, bool value) {
+	if(!value) {
+		printf("%s : false\n", name);
+		errors++;
+	}
+}
+
+int main(void) {
+	map_stats_t use;
+	uint32_t periods = 0;
+	uint16_t obstacles = 0;
+	uint16_t cells = 0;
+	uint32_t evictions = 0;
+	float lateral_max = 0;
+
+	// the wall is met : the robot moves along it, facing it, during the escape maneuvers
+	x = WALL_X - ROBOT_RADIUS - WALL_GAP;
+	for(y = -WALL_HALF - ROBOT_RADIUS ; y <= WALL_HALF + ROBOT_RADIUS ; y += WALL_STEP) {
+		map_update(true);
+	}
+	get_map_stats(&use);
+	expect("wall in the map", use.obstacles >= 2 * WALL_HALF / MAP_CELL);
+	expect("no route during the escapes", use.reroutes == 0);
+
+	// second descent, from BACK_UP uphill of the wall : the robot goes around it
+	x = WALL_X - BACK_UP;
+	y = 0;
+	while(x < WALL_X + 2 * MAP_CELL && periods < MAX_PERIODS) {
+		period();
+		periods++;
+		lateral_max = (fabsf(y) > lateral_max) ? fabsf(y) : lateral_max;
+	}
+	get_map_stats(&use);
+	obstacles = use.obstacles;
+	expect("wall passed", x >= WALL_X + 2 * MAP_CELL);
+	expect("no collision", collisions == 0);
+	expect("rerouted", use.reroutes >= 2 && lateral_max > WALL_HALF);
+	expect("route back to the descent", use.route == 0);
+	expect("no cell lost", use.evictions == 0);
+	printf("test_map : wall passed after %u periods, %.0f mm aside, %u obstacles, %u detections, %u reroutes\n",
+			periods, lateral_max, use.obstacles, use.detections, use.reroutes);
+
+	// the obstacle cells are on the wall
+	map_print(NULL);
+
+	// sweep of SWEEP_CELLS cells away from the wall : the free cells are replaced, the obstacles stay
+	heading = 0;
+	for(uint16_t i = 0 ; i < SWEEP_CELLS ; i++) {
+		x = WALL_X + 3 * MAP_CELL + (i / 20) * MAP_CELL;
+		y = ((i % 20) - 10) * MAP_CELL;
+		map_update(false);
+	}
+	get_map_stats(&use);
+	expect("free cells replaced", use.evictions > 0);
+	expect("obstacles kept", use.obstacles == obstacles && use.obstacles_lost == 0);
+
+	// on a small slope the map isn't written
+	cells = use.cells;
+	evictions = use.evictions;
+	flat = true;
+	x = -10 * MAP_CELL;
+	map_update(false);
+	get_map_stats(&use);
+	expect("flat surface ignored", use.cells == cells && use.evictions == evictions);
+
+	printf("test_map : %u cells swept, %u evictions, %u obstacles kept, %u errors\n", SWEEP_CELLS, use.evictions,
+			use.obstacles, errors);
+	return errors != 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * test_timebase.c
+ *
+ *  Created on: 19 oct. 2026
+ *      Author: alecp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ch.h>
+#include <hal.h>
+#include <timebase.h>
+
+/*
+ * Host test of the time base (timebase.c) against the overflow races of timer 12
+ * The timer is a model driven by the test : the time passes during each read of the counter, the overflow
+ * interrupt is only served out of the critical zones. A wrap can be injected between the read of the counter
+ * and the check of the update flag, the case where the counter is read again.
+ *
+ * usage : test_timebase [random reads (10000000)], returns 1 if a read is wrong
+ */
+
+GPTDriver GPTD12 = {0};
+
+static uint64_t now = 0; // true time [us]
+static uint64_t served = 0; // overflows whose interrupt has been served
+static bool locked = false;
+static uint32_t reads = 0; // reads of the counter
+static uint32_t step = 0; // time taken by a read of the counter [us]
+static uint32_t inject = 0; // time added after the next read of the counter [us]
+static uint32_t errors = 0;
+
+uint16_t test_timer_counter(void) {
+	uint16_t count = now % GPTD12.interval;
+
+	reads++;
+	now += step + inject;
+	inject = 0;
+	return count;
+}
+
+bool test_timer_wrap_pending(void) {
+	return now / GPTD12.interval > served;
+}
+
+// interrupt of the overflows, when the interrupts are enabled
+static void serve(void) {
+	while(!locked && now / GPTD12.interval > served) {
+		served++;
+		GPTD12.config->callback(&GPTD12);
+	}
+}
+
+syssts_t chSysGetStatusAndLockX(void) {
+	locked = true;
+	return 0;
+}
+
+void chSysRestoreStatusX(syssts_t status) {
+	(void)status;
+	locked = false;
+	serve();
+}
+
+void chSysLockFromISR(void) {
+}
+
+void chSysUnlockFromISR(void) {
+}
+
+/*
+ * one read of the time base
+ *
+ * \param expected		time that must be read, or UINT64_MAX for any time during the read
+ *
+ * \param nb_reads		reads of the counter expected, 0 for any
+ *
+ * \return				time read [us]
+ */
+static uint64_t check(const char* name, uint64_t expected, uint32_t nb_reads) {
+	uint64_t before = now;
+	uint64_t value = 0;
+
+	reads = 0;
+	value = timebase_us();
+	if((expected != UINT64_MAX && value != expected) || value < before || value > now
+			|| (nb_reads != 0 && reads != nb_reads)) {
+		if(errors < 10) {
+			printf("%s : read %llu us between %llu and %llu us (expected %lld), %u counter reads\n", name,
+					(unsigned long long)value, (unsigned long long)before, (unsigned long long)now,
+					(long long)expected, reads);
+		}
+		errors++;
+	}
+	return value;
+}
+
+int main(int argc, char* argv[]) {
+	uint32_t random_reads = (argc > 1) ? atoi(argv[1]) : 10000000;
+	uint64_t last = 0;
+	uint64_t value = 0;
+	uint32_t rereads = 0;
+
+	timebase_start();
+
+	// no overflow during the read : one read of the counter
+	now = 1000;
+	check("no wrap", 1000, 1);
+
+	// overflow between the read of the counter and the check of the flag : the counter is read again
+	now = 3 * TIMEBASE_WRAP - 1;
+	serve();
+	inject = 2;
+	check("wrap during the read", 3 * TIMEBASE_WRAP + 1, 2);
+
+	// overflow before the read, its interrupt not served yet (another interrupt is running)
+	now = 5 * TIMEBASE_WRAP - 1;
+	serve();
+	now += 11;
+	check("wrap pending", 5 * TIMEBASE_WRAP + 10, 2);
+	if(served != 5) {
+		printf("wrap pending : %llu overflows served instead of 5\n", (unsigned long long)served);
+		errors++;
+	}
+
+	// overflow exactly at the first read of the counter
+	now = 7 * TIMEBASE_WRAP - 1;
+	serve();
+	inject = 1;
+	check("wrap at the read", 7 * TIMEBASE_WRAP, 2);
+
+	// random reads : the time passes during the reads, wraps injected, interrupts delayed
+	srand(1);
+	last = now;
+	for(uint32_t i = 0 ; i < random_reads ; i++) {
+		step = rand() % 4;
+		inject = (rand() % 16 == 0) ? rand() % 8 : 0;
+		now += rand() % 200;
+		if(rand() % 2) {
+			serve(); // else the interrupt of an overflow during this delay is served late, in the read
+		}
+		value = check("random", UINT64_MAX, 0);
+		rereads += reads == 2;
+		if(value < last) {
+			if(errors < 10) {
+				printf("random : %llu us read after %llu us\n", (unsigned long long)value, (unsigned long long)last);
+			}
+			errors++;
+		}
+		last = value;
+	}
+
+	printf("test_timebase : %u random reads over %llu s, %u counters read again, %u errors\n", random_reads,
+			(unsigned long long)(now / 1000000), rereads, errors);
+	return errors != 0;
+}
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+blackbox.py
+
+Extracts and decodes the black box of the robot (miniprojet_SlopeFollower/blackbox.c).
+
+usage : blackbox.py <flash dump> [--boots n] [--csv samples.csv]
+
+The dump is the content of the sectors 8 to 10 of the flash, one after the other (384 kB from 0x08080000),
+read for example with the GDB server of the e-puck2 programmer :
+	(gdb) dump binary memory blackbox.bin 0x08080000 0x080E0000
+The flash file of the simulation (simulation/sim_flash.bin) can be given directly : its first sectors are the same.
+
+The sectors are put in order with their sequence number, then the records are read block by block.
+A block that is neither erased nor a valid record has been cut by a power loss : it is counted and skipped.
+The names of the movement states and events are read in regulation.c, so the decoding follows the code.
+"""
+
+import argparse
+import csv
+import os
+import re
+import struct
+import sys
+
+FIRMWARE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "miniprojet_SlopeFollower")
+
+SECTOR_SIZE = 0x20000
+NB_SECTORS = 3
+BLOCK = 32
+MAGIC = 0x42424F58 # "BBOX"
+RECORD = struct.Struct("<IBB11hI") # bb_record_t
+HEADER = struct.Struct("<II") # bb_header_t : magic, sequence
+
+BOOT, SAMPLE, TRANSITION = 1, 2, 3
+
+# content of a sample for each format (BB_* of blackbox.h) : name, scale
+FORMATS = {
+	1: [("heading", 0.01), ("inclination", 1), ("prox_alert", 1), ("prox_max", 1), ("prop", 1), ("integr", 1),
+		("deriv", 1), ("linear", 1), ("angular", 1), ("gyro", 0.1), ("jitter", 1)],
+}
+
+
+def names(prefix):
+	"""values of the #define <prefix>_* of regulation.c : {value: name}"""
+	result = {}
+	with open(os.path.join(FIRMWARE, "regulation.c"), encoding="latin-1") as f:
+		for line in f:
+			m = re.match(r"\s*#define\s+%s_(\w+)\s+(\S+)" % prefix, line)
+			if m and not m.group(1).startswith("NB_"):
+				value = 0 if m.group(2).startswith("FSM_") else int(m.group(2))
+				result[value] = m.group(1).lower()
+	return result
+
+
+def blocks(dump):
+	"""blocks of the log, oldest first : list of (sector sequence, block number, bytes)"""
+	sectors = []
+	for s in range(NB_SECTORS):
+		data = dump[s * SECTOR_SIZE:(s + 1) * SECTOR_SIZE]
+		if len(data) < SECTOR_SIZE:
+			break
+		magic, sequence = HEADER.unpack_from(data, 0)
+		if magic == MAGIC:
+			sectors.append((sequence, data))
+	# the sequence numbers wrap around : the oldest follows the biggest gap
+	sectors.sort()
+	if sectors and sectors[-1][0] - sectors[0][0] >= 0x80000000:
+		split = next(i for i in range(1, len(sectors)) if sectors[i][0] - sectors[i - 1][0] >= 0x80000000)
+		sectors = sectors[split:] + sectors[:split]
+	result = []
+	for sequence, data in sectors:
+		for b in range(1, SECTOR_SIZE // BLOCK):
+			result.append((sequence, b, data[b * BLOCK:(b + 1) * BLOCK]))
+	return result
+
+
+def decode(dump):
+	"""boots of the log : list of dict with the records, and the number of blocks cut by a power loss"""
+	boots = []
+	corrupted = 0
+	current = None
+	for sequence, number, block in blocks(dump):
+		if block == b"\xff" * BLOCK:
+			continue
+		words = struct.unpack("<8I", block)
+		if (MAGIC + sum(words[:7])) & 0xFFFFFFFF != words[7]:
+			corrupted += 1
+			continue
+		time, kind, state, *data = RECORD.unpack(block)[:-1]
+		if kind == BOOT or current is None:
+			current = {"sector": sequence, "block": number, "format": data[0] if kind == BOOT else None,
+					   "samples": [], "transitions": []}
+			boots.append(current)
+			if kind == BOOT:
+				continue
+		if kind == SAMPLE:
+			current["samples"].append((time, state, data))
+		elif kind == TRANSITION:
+			current["transitions"].append((time, data[0], data[1], data[2]))
+	return boots, corrupted
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.split("\n")[3])
+	parser.add_argument("dump")
+	parser.add_argument("--boots", type=int, default=1, help="number of boots to show, the last ones (default 1)")
+	parser.add_argument("--csv", help="writes the samples of the boots shown")
+	args = parser.parse_args()
+
+	with open(args.dump, "rb") as f:
+		dump = f.read(NB_SECTORS * SECTOR_SIZE)
+	boots, corrupted = decode(dump)
+	if not boots:
+		sys.exit("no record in %s" % args.dump)
+	states = names("ST")
+	events = names("EV")
+
+	print("%d boots recorded, %d blocks cut by a power loss" % (len(boots), corrupted))
+	rows = []
+	for boot in boots[-args.boots:]:
+		fields = FORMATS.get(boot["format"] or 1)
+		if fields is None:
+			print("\nboot in log sector %d : unknown format %s" % (boot["sector"], boot["format"]))
+			continue
+		samples = boot["samples"]
+		duration = (samples[-1][0] - samples[0][0]) if samples else 0
+		print("\nboot in log sector %d, block %d : %d samples over %.1f s, %d transitions" % (
+			boot["sector"], boot["block"], len(samples), duration / 1000, len(boot["transitions"])))
+		for time, src, dst, event in boot["transitions"]:
+			print("%10d ms  %-8s -> %-8s (%s)" % (time, states.get(src, src), states.get(dst, dst), events.get(event, event)))
+		if samples:
+			last = samples[-1]
+			print("last sample at %d ms in %s : %s" % (last[0], states.get(last[1], last[1]),
+				" ".join("%s %g" % (name, value * scale) for (name, scale), value in zip(fields, last[2]))))
+		for time, state, data in samples:
+			row = {"time": time, "state": states.get(state, state)}
+			row.update({name: round(value * scale, 2) for (name, scale), value in zip(fields, data)})
+			row["jitter"] = data[10] & 0xFFFF # unsigned
+			rows.append(row)
+
+	if args.csv and rows:
+		with open(args.csv, "w", newline="") as f:
+			writer = csv.DictWriter(f, fieldnames=list(rows[0]))
+			writer.writeheader()
+			writer.writerows(rows)
+		print("samples written to %s" % args.csv)
+
+
+if __name__ == "__main__":
+	main()
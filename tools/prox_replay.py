@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+prox_replay.py
+
+Replays IR logs through the proximity alerts of the firmware (prox.c) to trade the false alerts against the latency.
+
+usage : prox_replay.py <serial log> [<serial log> ...] [--weight w,w...] [--confirm n,n...] [--set NAME=value] [--real n]
+
+The logs are recorded with PROX_LOG (prox.c) : one line of the 6 calibrated values per period of the proximity
+thread, the other lines are ignored. For each configuration, prox.c is built with its #define replaced
+(FILTER_WEIGHT, CONFIRM_SAMPLES, and the ones given with --set) with simulation/prox_replay.c (make replay),
+and the log is given to prox_task() : the filter, the hysteresis and the confirmation are the code of the firmware.
+The first configuration is the single raw sample (PROX_FILTER false), as before the filter.
+
+Reference : the logs aren't labelled, an obstacle is a run of at least --real consecutive raw samples
+with an alert (any sensor), a shorter run is noise. The reference knows the future : it isn't an alert
+the firmware could give, only the truth against which the configurations are compared.
+	alerts          episodes of alert given to the regulator (one escape maneuver each)
+	false           episodes that don't overlap an obstacle : escapes for nothing
+	missed          obstacles without alert during their run
+	latency [ms]    from the first raw sample of an obstacle to its alert, mean and max (missed excluded)
+The replay is open loop : the robot of the log moved with the alerts of the firmware that recorded it,
+a configuration that reacts later would have met the obstacles closer.
+
+examples :
+	prox_replay.py run1.log run2.log
+	prox_replay.py run.log --weight 0.5 --confirm 1,2,3 --set PROXIMITY_TRESHOLD_EXIT=600
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FIRMWARE = os.path.join(HERE, "..", "miniprojet_SlopeFollower")
+SIMULATION = os.path.join(HERE, "..", "simulation")
+PROX = os.path.join(FIRMWARE, "prox.c")
+
+
+def read_define(name, text):
+	"""value of a #define in the text of a source"""
+	m = re.search(r"^#define\s+%s\s+(\S+)" % name, text, re.M)
+	if not m:
+		sys.exit("%s not found in prox.c" % name)
+	return m.group(1)
+
+
+def replace_define(name, value, text):
+	"""text of a source with the value of a #define replaced, its comment kept"""
+	read_define(name, text)
+	return re.sub(r"^(#define\s+%s\s+)\S+" % name, lambda m: m.group(1) + value, text, count=1, flags=re.M)
+
+
+def replay(defines, logs, workdir):
+	"""(raw alert, alert) of each sample of each log, with prox.c built with the defines"""
+	with open(PROX, encoding="latin-1") as f:
+		text = f.read()
+	for name, value in defines.items():
+		text = replace_define(name, value, text)
+	source = os.path.join(workdir, "prox.c")
+	with open(source, "w", encoding="latin-1") as f:
+		f.write(text)
+	subprocess.run(["make", "-s", "-C", SIMULATION, "replay", "PROXSRC=" + source, "BUILDDIR=" + workdir], check=True)
+
+	result = []
+	for log in logs:
+		with open(log, "rb") as f:
+			out = subprocess.run([os.path.join(workdir, "prox_replay")], stdin=f, capture_output=True, text=True, check=True).stdout
+		result.append([tuple(int(x) for x in line.split()[:2]) for line in out.splitlines()])
+	os.remove(os.path.join(workdir, "prox_replay"))
+	return result
+
+
+def runs(values):
+	"""[start, end[ of the runs of non-zero values"""
+	result = []
+	start = None
+	for i, v in enumerate(values + [0]):
+		if v != 0 and start is None:
+			start = i
+		elif v == 0 and start is not None:
+			result.append((start, i))
+			start = None
+	return result
+
+
+def score(samples, real):
+	"""alerts, false alerts, latencies [samples] and missed obstacles of one log"""
+	obstacles = [r for r in runs([raw for raw, alert in samples]) if r[1] - r[0] >= real]
+	alerts = runs([alert for raw, alert in samples])
+	false = sum(1 for a in alerts if not any(a[0] < o[1] and o[0] < a[1] for o in obstacles))
+	latencies = []
+	missed = 0
+	for o in obstacles:
+		first = next((i for i in range(o[0], o[1]) if samples[i][1] != 0), None)
+		if first is None:
+			missed += 1
+		else:
+			latencies.append(first - o[0])
+	return len(alerts), false, latencies, missed, len(obstacles)
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.split("\n")[3])
+	parser.add_argument("logs", nargs="+")
+	parser.add_argument("--weight", default="1,0.7,0.5,0.3", help="values of FILTER_WEIGHT")
+	parser.add_argument("--confirm", default="1,2,3", help="values of CONFIRM_SAMPLES")
+	parser.add_argument("--set", action="append", default=[], metavar="NAME=value", help="other #define of prox.c")
+	parser.add_argument("--real", type=int, default=3, help="raw samples in a row for an obstacle of the reference")
+	args = parser.parse_args()
+
+	with open(PROX, encoding="latin-1") as f:
+		period = int(read_define("PROXIMITY_PERIOD", f.read()))
+	common = dict(s.split("=", 1) for s in args.set)
+	configs = [("single sample", dict(common, PROX_FILTER="false"))]
+	for w in args.weight.split(","):
+		for n in args.confirm.split(","):
+			configs.append(("weight %s confirm %s" % (w, n), dict(common, PROX_FILTER="true", FILTER_WEIGHT=repr(float(w)) + "f", CONFIRM_SAMPLES=n)))
+
+	print("%d log(s), period %d ms, obstacle : %d raw samples in a row %s" % (len(args.logs), period, args.real,
+			" ".join("%s=%s" % item for item in common.items())))
+	print("%-26s %8s %8s %8s %8s %12s %12s" % ("configuration", "alerts", "false", "false/min", "missed", "latency", "latency max"))
+	with tempfile.TemporaryDirectory() as workdir:
+		for name, defines in configs:
+			alerts = false = missed = obstacles = samples = 0
+			latencies = []
+			for log in replay(defines, args.logs, workdir):
+				a, f, l, m, o = score(log, args.real)
+				alerts += a
+				false += f
+				latencies += l
+				missed += m
+				obstacles += o
+				samples += len(log)
+			minutes = samples * period / 60000
+			mean = "%.0f" % (sum(latencies) * period / len(latencies)) if latencies else "-"
+			worst = "%d" % (max(latencies) * period) if latencies else "-"
+			print("%-26s %8d %8d %8.2f %5d/%-2d %12s %12s" % (name, alerts, false, false / minutes if minutes else 0,
+					missed, obstacles, mean, worst))
+
+
+if __name__ == "__main__":
+	main()
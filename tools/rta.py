@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+"""
+rta.py
+
+Response-time analysis of the task set of the firmware (miniprojet_SlopeFollower).
+
+usage : rta.py [--trace log] [--wcet task=us] [--period task=ms] [--add name:period:prio:wcet] [--executive]
+
+The periods are read in the sources, so the analysis follows the code. The angle computation
+runs at its real period (angle_fast_period() of sysid.py) : with IMU_TOPIC, a whole number of IMU samples.
+The worst-case execution times are estimations until they are measured :
+give them with --wcet, or with --trace and a serial log containing a trace dump
+(TRACE_DUMP in trace.h) : the longest job of each thread is then used.
+
+Fixed-priority preemptive analysis (ChibiOS : a bigger number is a higher priority) :
+	R = C + sum over the tasks j of higher or equal priority (j != i) of ceil(R / Tj) * Cj
+The threads of equal priority are counted as interference : with the round robin
+(CH_CFG_TIME_QUANTUM) any of them can run before the task, it is a safe bound.
+The interrupts (system tick, motor steps) are tasks above all the threads,
+and each job pays two context switches.
+
+Blocking : while the black box programs a word of the flash, the reads of the flash wait and all the code
+stops, interrupts included, whatever its priority. The black box can be preempted between two words :
+every other task and interrupt is blocked at most once per job, by one word (B, FLASH_STALL_US).
+	R = B + C + interference
+The erases (1 to 2 s) are only done at the boot, the motors stopped : they are not in the analysis.
+
+The deadline is the period. The breakdown factor is the biggest factor
+that can multiply all the execution times with the task set still schedulable :
+it is the headroom left before pushing the loops to higher rates.
+
+examples :
+	rta.py
+	rta.py --period regulator=1 --period angle=1
+	rta.py --add logger:20:NORMALPRIO:300
+	rta.py --trace serial.log
+"""
+
+import argparse
+import math
+import os
+import re
+import sys
+
+from sysid import angle_fast_period
+
+FIRMWARE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "miniprojet_SlopeFollower")
+
+NORMALPRIO = 128 # ChibiOS
+ISR_PRIO = 1000 # above all the threads
+
+SWITCH_US = 1.5 # cost of one context switch (measured order of magnitude on a Cortex-M4 at 168 MHz)
+FLASH_STALL_US = 16 # programming of one word of the flash : all the code stops (STM32F407 datasheet, typical)
+FLASH_TASK = "blackbox" # task programming the flash during the run
+
+# task set : name, thread name (as in the trace), period [ms] (define and file, function or number), priority, WCET [us]
+# the WCET are estimations, replace them with measurements (--trace or --wcet)
+TASKS = [
+	("regulator",		"Regulator",			("REGUL_PERIOD", "control.h"),			"NORMALPRIO+1",	60),
+	("rate",			"Rate",					("RATE_PERIOD", "regulation.c"),			"NORMALPRIO+2",	30),	# with CASCADE only
+	("angle",			"compute_angle_thd",	angle_fast_period,							"NORMALPRIO",	80),	# 4 ms with IMU_TOPIC
+	("proximity",		"get_proximity_thd",	("PROXIMITY_PERIOD", "prox.c"),				"NORMALPRIO",	60),
+	("blackbox",		"blackbox_thd",			("BB_PERIOD", "blackbox.c"),				"NORMALPRIO-1",	300),	# programs the flash : blocks all the others (FLASH_STALL_US)
+	# threads of the e-puck2 library
+	("imu_lib",			"imu_reader_thd",		4,											"NORMALPRIO",	150),
+	("proximity_lib",	"proximity_thd",		10,											"NORMALPRIO",	100),
+]
+
+# interrupts : name, period [ms], WCET [us]
+ISRS = [
+	("systick",			("CH_CFG_ST_FREQUENCY", "chconf.h"),	2),
+	("motor_left",		1,										1),	# one step interrupt at SPEED_MAX (1000 step/s)
+	("motor_right",		1,										1),
+]
+
+
+def read_define(name, filename):
+	"""value of a #define of the firmware"""
+	with open(os.path.join(FIRMWARE, filename), encoding="latin-1") as f:
+		for line in f:
+			m = re.match(r"\s*#define\s+%s\s+(\S+)" % name, line)
+			if m:
+				return m.group(1)
+	sys.exit("%s not found in %s" % (name, filename))
+
+
+def priority(text):
+	"""priority of ChibiOS written as in the sources (NORMALPRIO+1)"""
+	return eval(text.replace(" ", ""), {"NORMALPRIO": NORMALPRIO})
+
+
+def task_set(executive):
+	"""tasks read from the sources : list of dict"""
+	tasks = []
+	for name, thread, period, prio, wcet in TASKS:
+		if isinstance(period, tuple):
+			period = float(read_define(*period))
+		elif callable(period):
+			period = float(period())
+		tasks.append({"name": name, "thread": thread, "T": period, "prio": priority(prio), "C": wcet})
+
+	# inner loop of the cascaded control
+	if read_define("CASCADE", "regulation.h") != "true":
+		tasks = [t for t in tasks if t["name"] != "rate"]
+
+	# with the cyclic executive, one thread runs the control tasks in its minor frame
+	if executive:
+		own = [t for t in tasks if t["name"] in ("angle", "proximity", "regulator", "rate")]
+		frame = float(read_define("MINOR_FRAME", "executive.c"))
+		tasks = [t for t in tasks if t not in own]
+		tasks.insert(0, {"name": "executive", "thread": "executive_thd", "T": frame,
+						"prio": priority("NORMALPRIO+1"), "C": sum(t["C"] for t in own)})
+
+	for name, period, wcet in ISRS:
+		if isinstance(period, tuple):
+			period = 1000.0 / float(read_define(*period))
+		tasks.append({"name": name, "thread": None, "T": period, "prio": ISR_PRIO, "C": wcet})
+	return tasks
+
+
+def trace_wcet(log):
+	"""longest job of each thread in the last trace dump of a serial log [us]"""
+	sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+	import trace_timeline
+
+	with open(log, errors="replace") as f:
+		block = trace_timeline.read_block(f)
+	names = {}
+	switches = []
+	for fields in block:
+		if fields[0] == "THREAD":
+			names[fields[1]] = fields[2]
+		elif fields[0] == "SWITCH":
+			switches.append((int(fields[1]), int(fields[2]), fields[3], int(fields[5])))
+	times = trace_timeline.unwrap([(s[0], s[1]) for s in switches])
+
+	# a job ends when its thread is switched out without being ready (it waits for its next release)
+	jobs = {}
+	longest = {}
+	for i in range(len(switches) - 1):
+		name = names.get(switches[i][2], switches[i][2])
+		jobs[name] = jobs.get(name, 0) + times[i + 1] - times[i]
+		if switches[i + 1][3] != trace_timeline.CH_STATE_READY:
+			longest[name] = max(longest.get(name, 0), jobs[name])
+			jobs[name] = 0
+	return longest
+
+
+def blocking(task, tasks):
+	"""longest time the task can be stopped by the flash programming [us]"""
+	if task["name"] == FLASH_TASK or FLASH_TASK not in [t["name"] for t in tasks]:
+		return 0
+	return FLASH_STALL_US
+
+
+def response_times(tasks, factor=1.0):
+	"""worst-case response time of each task [us], None if it misses its deadline"""
+	result = []
+	for task in tasks:
+		switch = 0 if task["prio"] == ISR_PRIO else 2 * SWITCH_US
+		c = blocking(task, tasks) + task["C"] * factor + switch
+		deadline = task["T"] * 1000
+		others = [t for t in tasks if t is not task and t["prio"] >= task["prio"]]
+		r = c
+		while True:
+			nxt = c
+			for t in others:
+				cost = t["C"] * factor + (0 if t["prio"] == ISR_PRIO else 2 * SWITCH_US)
+				nxt += math.ceil(r / (t["T"] * 1000)) * cost
+			if nxt > deadline:
+				r = None
+				break
+			if nxt == r:
+				break
+			r = nxt
+		result.append(r)
+	return result
+
+
+def breakdown(tasks):
+	"""biggest factor on the execution times keeping the task set schedulable"""
+	low, high = 0.0, 1.0
+	while None not in response_times(tasks, high) and high < 1e6:
+		low, high = high, high * 2
+	for _ in range(40):
+		mid = (low + high) / 2
+		if None in response_times(tasks, mid):
+			high = mid
+		else:
+			low = mid
+	return low
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.split("\n")[3])
+	parser.add_argument("--trace", help="serial log with a trace dump, to use the measured execution times")
+	parser.add_argument("--wcet", action="append", default=[], metavar="TASK=US", help="execution time of a task")
+	parser.add_argument("--period", action="append", default=[], metavar="TASK=MS", help="new period of a task")
+	parser.add_argument("--add", action="append", default=[], metavar="NAME:PERIOD:PRIO:WCET", help="new task")
+	parser.add_argument("--executive", action="store_true", default=None,
+						help="analyse the cyclic executive (default : CYCLIC_EXECUTIVE in executive.h)")
+	args = parser.parse_args()
+
+	executive = args.executive
+	if executive is None:
+		executive = read_define("CYCLIC_EXECUTIVE", "executive.h") == "true"
+	tasks = task_set(executive)
+	by_name = {t["name"]: t for t in tasks}
+
+	if args.trace:
+		measured = trace_wcet(args.trace)
+		for t in tasks:
+			if t["thread"] in measured:
+				t["C"] = measured[t["thread"]]
+				t["measured"] = True
+	for text in args.wcet:
+		name, value = text.split("=")
+		by_name[name]["C"] = float(value)
+		by_name[name]["measured"] = True
+	for text in args.period:
+		name, value = text.split("=")
+		by_name[name]["T"] = float(value)
+	for text in args.add:
+		name, period, prio, wcet = text.split(":")
+		tasks.append({"name": name, "thread": name, "T": float(period), "prio": priority(prio), "C": float(wcet)})
+
+	tasks.sort(key=lambda t: -t["prio"])
+	rts = response_times(tasks)
+
+	print("%-14s %6s %8s %8s %6s %7s %10s %10s" % ("task", "prio", "T [ms]", "C [us]", "B [us]", "U", "R [us]", "slack [us]"))
+	utilization = 0
+	for task, r in zip(tasks, rts):
+		u = task["C"] / (task["T"] * 1000)
+		utilization += u
+		prio = "isr" if task["prio"] == ISR_PRIO else "N%+d" % (task["prio"] - NORMALPRIO) if task["prio"] != NORMALPRIO else "N"
+		c = "%d%s" % (task["C"], "" if task.get("measured") else "*")
+		b = blocking(task, tasks)
+		if r is None:
+			print("%-14s %6s %8g %8s %6g %6.2f%% %10s %10s" % (task["name"], prio, task["T"], c, b, 100 * u, "MISS", "-"))
+		else:
+			print("%-14s %6s %8g %8s %6g %6.2f%% %10.1f %10.1f" % (task["name"], prio, task["T"], c, b, 100 * u, r, task["T"] * 1000 - r))
+
+	print("* estimated execution time, not measured")
+	print("utilization %.2f %%, headroom %.2f %%" % (100 * utilization, 100 * (1 - utilization)))
+	factor = breakdown(tasks)
+	print("breakdown factor %.2f : the execution times can be multiplied by %.2f before a deadline is missed" % (factor, factor))
+
+	if None in rts:
+		print("NOT SCHEDULABLE")
+		sys.exit(1)
+	print("schedulable")
+
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""
+sysid.py
+
+Fits the yaw model of the robot on the runs recorded with REGUL_LOG (miniprojet_SlopeFollower/regulation.c).
+
+usage : sysid.py <serial log> [<serial log> ...] [--surface name] [-o model.json]
+
+The log lines "REG <time [ms]> <heading [0.01 deg]> <speed difference [step/s]> <flat>" are used,
+the other lines are ignored. The samples on a flat surface (heading undefined) cut the record in segments.
+
+Model (first order with dead time, integrating) :
+	rotation speed w [deg/s, to the right] : tau * dw/dt = -w + K * u(t - L)
+	heading : dheading/dt = -w (the slope goes to the left when the robot turns right)
+u is the speed difference applied to the wheels (after the limits of drive.c), so the model is the robot and
+the measurement of the heading. K, tau and L are fitted by least squares on the heading increments
+(grid on tau and L, K is linear).
+
+Fit quality :
+	R2              part of the variance of the heading increments explained by the model
+	prediction RMS  error of the heading predicted from the inputs only, over PREDICTION_HORIZON
+
+The moving average of the heading (angle.c) delays the measurement : it is part of the fitted dead time.
+The model given to the simulator (SIM_YAW_* of plant.c) is the robot only : this delay is removed,
+the simulation runs the same averaging.
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import sys
+
+FIRMWARE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "miniprojet_SlopeFollower")
+
+STEP_MM = 0.13 # [mm]
+WHEEL_BASE = 53.0 # [mm]
+K_KINEMATIC = 2 * STEP_MM / WHEEL_BASE * 180 / math.pi # rotation without slip [deg/s per step/s]
+
+PREDICTION_HORIZON = 1000 # [ms]
+MAX_DEAD_TIME = 150 # [ms]
+MAX_TAU = 400 # [ms]
+TAU_STEP = 5 # [ms]
+PERIOD_TOLERANCE = 1 # jitter of the logged time accepted between two samples of a segment (timebase_ms() rounding) [ms]
+
+
+def read_define(name, filename):
+	"""value of a #define of the firmware (text)"""
+	with open(os.path.join(FIRMWARE, filename), encoding="latin-1") as f:
+		for line in f:
+			m = re.match(r"\s*#define\s+%s\s+(\S+)" % name, line)
+			if m:
+				return m.group(1)
+	sys.exit("%s not found in %s" % (name, filename))
+
+
+def angle_fast_period():
+	"""real fast period of the angle computation [ms], as ANGLE_PERIOD_FAST in angle.c"""
+	period = int(read_define("COMPUTE_ANGLE_PERIOD", "angle.c"))
+	imu = int(read_define("IMU_PERIOD", "angle.c"))
+	if read_define("IMU_TOPIC", "angle.c") != "true" or read_define("CYCLIC_EXECUTIVE", "executive.h") == "true":
+		return period
+	return max(period // imu, 1) * imu
+
+
+def segments(logs):
+	"""segments of consecutive samples on the slope : lists of (time, unwrapped heading [deg], input)
+	the period is the median time step, a step further than PERIOD_TOLERANCE from it is a missing sample"""
+	records = []
+	for log in logs:
+		samples = []
+		with open(log, errors="replace") as f:
+			for line in f:
+				fields = line.split()
+				if len(fields) != 5 or fields[0] != "REG":
+					continue
+				samples.append(tuple(int(x) for x in fields[1:]))
+		records.append(samples)
+
+	steps = sorted(b[0] - a[0] for samples in records for a, b in zip(samples, samples[1:]))
+	period = steps[len(steps) // 2] if steps else None
+
+	result = []
+	for samples in records:
+		current = []
+		for t, heading, u, flat in samples:
+			if flat or (current and abs(t - current[-1][0] - period) > PERIOD_TOLERANCE):
+				if len(current) > 1:
+					result.append(current)
+				current = []
+				if flat:
+					continue
+			if current:
+				# unwrap : the heading is in [-180, 180]
+				step = (heading / 100 - current[-1][1] + 180) % 360 - 180
+				current.append((t, current[-1][1] + step, u))
+			else:
+				current.append((t, heading / 100, u))
+		if len(current) > 1:
+			result.append(current)
+	return result, period
+
+
+def regressor(seg, a, d):
+	"""input delayed by d samples and filtered by the first order of pole a"""
+	x = []
+	state = 0.0
+	for k in range(len(seg)):
+		u = seg[k - d][2] if k >= d else seg[0][2]
+		state = a * state + (1 - a) * u
+		x.append(state)
+	return x
+
+
+def fit(segs, period):
+	"""best (K, tau, L, sse, sst) on all the segments"""
+	best = None
+	increments = [seg[k + 1][1] - seg[k][1] for seg in segs for k in range(len(seg) - 1)]
+	mean = sum(increments) / len(increments)
+	sst = sum((y - mean) ** 2 for y in increments)
+	T = period / 1000
+
+	for d in range(0, int(MAX_DEAD_TIME / period) + 1):
+		for tau in range(0, MAX_TAU + 1, TAU_STEP):
+			a = math.exp(-period / tau) if tau > 0 else 0.0
+			sxy = sxx = syy = 0.0
+			for seg in segs:
+				x = regressor(seg, a, d)
+				for k in range(len(seg) - 1):
+					y = seg[k + 1][1] - seg[k][1]
+					sxy += y * x[k]
+					sxx += x[k] * x[k]
+					syy += y * y
+			if sxx == 0:
+				continue
+			k_gain = -sxy / (T * sxx)
+			sse = syy - sxy * sxy / sxx
+			if best is None or sse < best[3]:
+				best = (k_gain, tau, d * period, sse, sst)
+	if best is None:
+		sys.exit("the input never changes : nothing to fit")
+	return best
+
+
+def prediction_rms(segs, period, k_gain, tau, dead):
+	"""RMS error of the heading predicted from the inputs only, restarted every PREDICTION_HORIZON [deg]"""
+	a = math.exp(-period / tau) if tau > 0 else 0.0
+	T = period / 1000
+	horizon = int(PREDICTION_HORIZON / period)
+	sum2 = 0.0
+	n = 0
+	for seg in segs:
+		x = regressor(seg, a, int(dead / period))
+		for start in range(0, len(seg) - 1, horizon):
+			predicted = seg[start][1]
+			for k in range(start, min(start + horizon, len(seg) - 1)):
+				predicted -= T * k_gain * x[k]
+				sum2 += (predicted - seg[k + 1][1]) ** 2
+				n += 1
+	return math.sqrt(sum2 / n) if n else float("nan")
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.split("\n")[3])
+	parser.add_argument("logs", nargs="+")
+	parser.add_argument("--surface", default="unnamed", help="name of the surface, kept in the model")
+	parser.add_argument("-o", "--output", help="model file (JSON)")
+	args = parser.parse_args()
+
+	segs, period = segments(args.logs)
+	samples = sum(len(s) for s in segs)
+	if samples < 50:
+		sys.exit("not enough samples on the slope (%d)" % samples)
+
+	k_gain, tau, dead, sse, sst = fit(segs, period)
+	r2 = 1 - sse / sst if sst > 0 else float("nan")
+	rms = prediction_rms(segs, period, k_gain, tau, dead)
+
+	# delay of the moving average of the heading (half of the window), with the fast period of the angle
+	fast = angle_fast_period()
+	size = (int(read_define("AVERAGE_ANGLE_TIME", "estimate.h")) + fast // 2) // fast # AVERAGE_ANGLE_SIZE
+	measurement = (size - 1) / 2 * fast
+	sim = {
+		"SIM_YAW_GAIN": round(k_gain / K_KINEMATIC, 3),
+		"SIM_YAW_TAU": tau,
+		"SIM_YAW_DELAY": int(max(dead - measurement, 0)),
+	}
+
+	print("surface %s : %d samples in %d segments, period %d ms" % (args.surface, samples, len(segs), period))
+	print("gain K          %.4f deg/s per step/s (%.2f of the kinematic gain)" % (k_gain, k_gain / K_KINEMATIC))
+	print("time constant   %d ms" % tau)
+	print("dead time       %d ms (measurement %.1f ms included)" % (dead, measurement))
+	print("R2              %.3f" % r2)
+	print("prediction RMS  %.2f deg over %d ms" % (rms, PREDICTION_HORIZON))
+	print(" ".join("%s=%s" % item for item in sim.items()))
+
+	if args.output:
+		model = {
+			"surface": args.surface,
+			"period_ms": period,
+			"gain": k_gain,
+			"tau_ms": tau,
+			"dead_time_ms": dead,
+			"measurement_delay_ms": measurement,
+			"r2": r2,
+			"prediction_rms_deg": rms,
+			"sim_env": sim,
+		}
+		with open(args.output, "w") as f:
+			json.dump(model, f, indent=1)
+		print("model written to %s" % args.output)
+
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+trace_timeline.py
+
+Draws the scheduler timeline sent by trace_dump() (miniprojet_SlopeFollower/trace.c).
+
+usage : trace_timeline.py <serial log> [-o timeline.svg]
+
+The log can contain other lines (boot report, run performance) : only the last
+block between "TRACE BEGIN" and "TRACE END" is used.
+Each thread gets one row, a rectangle is drawn each time it runs.
+A red mark shows a preemption (the thread switched out was still ready),
+a grey mark the interrupts served between two switches.
+A summary (run time, releases, preemptions, idle time) is printed.
+"""
+
+import argparse
+import sys
+
+CH_STATE_READY = 0 # state of a thread switched out while it could still run
+
+ROW_HEIGHT = 24
+LEFT_MARGIN = 170
+PX_PER_MS = 40
+
+
+def read_block(lines):
+	"""returns the lines of the last complete trace block"""
+	block = None
+	current = None
+	for line in lines:
+		line = line.strip()
+		if line.startswith("TRACE BEGIN"):
+			current = []
+		elif line.startswith("TRACE END") and current is not None:
+			block = current
+			current = None
+		elif current is not None:
+			current.append(line.split())
+	if block is None:
+		sys.exit("no complete trace in the log")
+	return block
+
+
+def unwrap(switches):
+	"""
+	absolute time [us] of each switch
+	the time base is sent on 32 bit : it wraps around after 71 min, far longer than a trace
+	"""
+	times = []
+	for ms, us in switches:
+		if times:
+			times.append(times[-1] + (us - last_us) % 2**32)
+		else:
+			times.append(us)
+		last_us = us
+	return times
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+	parser.add_argument("log")
+	parser.add_argument("-o", "--output", default="timeline.svg")
+	args = parser.parse_args()
+
+	with open(args.log, errors="replace") as f:
+		block = read_block(f)
+
+	names = {}
+	switches = []
+	for fields in block:
+		if fields[0] == "THREAD":
+			names[fields[1]] = fields[2]
+		elif fields[0] == "SWITCH":
+			switches.append((int(fields[1]), int(fields[2]), fields[3], int(fields[4]), int(fields[5])))
+		elif fields[0] == "KSTAT":
+			print("interrupts %s, context switches %s since the boot" % (fields[1], fields[2]))
+
+	if len(switches) < 2:
+		sys.exit("not enough context switches in the trace")
+
+	times = unwrap([(s[0], s[1]) for s in switches])
+	origin = times[0]
+
+	# running intervals : a switch starts the thread switched in, the next one ends it
+	threads = {}
+	for i in range(len(switches) - 1):
+		tp = switches[i][2]
+		t = threads.setdefault(tp, {"runs": [], "preempted": 0, "releases": 0})
+		t["runs"].append((times[i] - origin, times[i + 1] - origin, switches[i + 1][4]))
+		if switches[i + 1][3] == CH_STATE_READY:
+			t["preempted"] += 1
+			t["runs"][-1] = t["runs"][-1] + ("preempted",)
+		else:
+			t["releases"] += 1
+
+	total = times[-1] - origin
+	order = sorted(threads, key=lambda tp: names.get(tp, tp))
+
+	print("%-24s %10s %8s %9s %11s" % ("thread", "run [us]", "load", "releases", "preemptions"))
+	for tp in order:
+		t = threads[tp]
+		run = sum(end - start for start, end, *rest in t["runs"])
+		print("%-24s %10d %7.2f%% %9d %11d" % (names.get(tp, tp), run, 100.0 * run / total, t["releases"], t["preempted"]))
+	print("trace duration %d us" % total)
+
+	# SVG timeline
+	width = LEFT_MARGIN + total / 1000 * PX_PER_MS + 20
+	height = (len(order) + 1) * ROW_HEIGHT
+	svg = ['<svg xmlns="http://www.w3.org/2000/svg" width="%d" height="%d" font-family="monospace" font-size="12">' % (width, height)]
+	for ms in range(0, int(total / 1000) + 1):
+		x = LEFT_MARGIN + ms * PX_PER_MS
+		svg.append('<line x1="%.1f" y1="0" x2="%.1f" y2="%d" stroke="#eee"/>' % (x, x, height))
+		if ms % 5 == 0:
+			svg.append('<text x="%.1f" y="%d" fill="#888">%d ms</text>' % (x + 2, height - 6, ms))
+	for row, tp in enumerate(order):
+		y = row * ROW_HEIGHT
+		name = names.get(tp, tp)
+		svg.append('<text x="4" y="%d">%s</text>' % (y + 16, name))
+		color = "#ccc" if name == "idle" else "#4a7"
+		for run in threads[tp]["runs"]:
+			start, end, irqs = run[0], run[1], run[2]
+			x = LEFT_MARGIN + start / 1000 * PX_PER_MS
+			w = max((end - start) / 1000 * PX_PER_MS, 0.5)
+			svg.append('<rect x="%.2f" y="%d" width="%.2f" height="%d" fill="%s"><title>%s %d us</title></rect>'
+					% (x, y + 4, w, ROW_HEIGHT - 8, color, name, end - start))
+			if len(run) > 3:
+				svg.append('<rect x="%.2f" y="%d" width="1.5" height="%d" fill="#d22"/>' % (x + w, y + 2, ROW_HEIGHT - 4))
+			if irqs:
+				svg.append('<rect x="%.2f" y="%d" width="1" height="3" fill="#666"><title>%d interrupts</title></rect>'
+						% (x + w, y + ROW_HEIGHT - 4, irqs))
+	svg.append("</svg>")
+
+	with open(args.output, "w") as f:
+		f.write("\n".join(svg))
+	print("timeline written to %s" % args.output)
+
+
+if __name__ == "__main__":
+	main()